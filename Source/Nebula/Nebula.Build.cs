@@ -10,6 +10,8 @@ public class Nebula : ModuleRules
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", });
 
-        PrivateDependencyModuleNames.AddRange(new string[] { "ReplicationGraph" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "ReplicationGraph", "IrisCore" });
+
+		SetupIrisSupport(Target);
     }
 }
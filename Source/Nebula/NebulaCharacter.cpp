@@ -7,6 +7,7 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/Controller.h"
+#include "Engine/World.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
@@ -54,6 +55,131 @@ ANebulaCharacter::ANebulaCharacter()
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 }
 
+//////////////////////////////////////////////////////////////////////////
+// FastShared replication
+
+FSharedRepMovement::FSharedRepMovement()
+{
+	// Must match ACharacter's ReplicatedMovement, checked in UNebulaReplicationGraph::InitGlobalActorClassSettings.
+	RepMovement.LocationQuantizationLevel = EVectorQuantization::RoundTwoDecimals;
+}
+
+bool FSharedRepMovement::FillForCharacter(ACharacter* Character)
+{
+	USceneComponent* PawnRootComponent = Character->GetRootComponent();
+	UCharacterMovementComponent* CharacterMovement = Character->GetCharacterMovement();
+	if (PawnRootComponent == nullptr || CharacterMovement == nullptr)
+	{
+		return false;
+	}
+
+	RepMovement.Location = FRepMovement::RebaseOntoZeroOrigin(PawnRootComponent->GetComponentLocation(), Character);
+	RepMovement.Rotation = PawnRootComponent->GetComponentRotation();
+	RepMovement.LinearVelocity = CharacterMovement->Velocity;
+	RepMovementMode = CharacterMovement->PackNetworkMovementMode();
+	bProxyIsJumpForceApplied = Character->bProxyIsJumpForceApplied || (Character->JumpForceTimeRemaining > 0.0f);
+	bIsCrouched = Character->IsCrouched();
+
+	// Timestamp is sent as zero if unused
+	if ((CharacterMovement->NetworkSmoothingMode == ENetworkSmoothingMode::Linear) || CharacterMovement->bNetworkAlwaysReplicateTransformUpdateTimestamp)
+	{
+		RepTimeStamp = CharacterMovement->GetServerLastTransformUpdateTimeStamp();
+	}
+	else
+	{
+		RepTimeStamp = 0.f;
+	}
+
+	return true;
+}
+
+bool FSharedRepMovement::Equals(const FSharedRepMovement& Other) const
+{
+	return RepMovement.Location == Other.RepMovement.Location
+		&& RepMovement.Rotation == Other.RepMovement.Rotation
+		&& RepMovement.LinearVelocity == Other.RepMovement.LinearVelocity
+		&& RepMovementMode == Other.RepMovementMode
+		&& bProxyIsJumpForceApplied == Other.bProxyIsJumpForceApplied
+		&& bIsCrouched == Other.bIsCrouched;
+}
+
+bool FSharedRepMovement::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+	RepMovement.NetSerialize(Ar, Map, bOutSuccess);
+	Ar << RepMovementMode;
+	Ar << bProxyIsJumpForceApplied;
+	Ar << bIsCrouched;
+
+	// Timestamp, if non-zero.
+	uint8 bHasTimeStamp = (RepTimeStamp != 0.f);
+	Ar.SerializeBits(&bHasTimeStamp, 1);
+	if (bHasTimeStamp)
+	{
+		Ar << RepTimeStamp;
+	}
+	else
+	{
+		RepTimeStamp = 0.f;
+	}
+
+	return true;
+}
+
+bool ANebulaCharacter::UpdateSharedReplication()
+{
+	if (GetLocalRole() != ROLE_Authority)
+	{
+		return false;
+	}
+
+	FSharedRepMovement SharedMovement;
+	if (!SharedMovement.FillForCharacter(this))
+	{
+		// We cannot fastrep right now. Don't send anything.
+		return false;
+	}
+
+	// Skipping the call reuses the bunch produced last time : connections that already received it get nothing, a connection that hasn't gets it this frame.
+	if (!SharedMovement.Equals(LastSharedReplication))
+	{
+		LastSharedReplication = SharedMovement;
+		SetReplicatedMovementMode(SharedMovement.RepMovementMode);
+
+		FastSharedReplication(SharedMovement);
+	}
+	return true;
+}
+
+void ANebulaCharacter::FastSharedReplication_Implementation(const FSharedRepMovement& SharedRepMovement)
+{
+	if (GetWorld()->IsPlayingReplay() || GetLocalRole() != ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
+	SetReplicatedServerLastTransformUpdateTimeStamp(SharedRepMovement.RepTimeStamp);
+
+	if (GetReplicatedMovementMode() != SharedRepMovement.RepMovementMode)
+	{
+		SetReplicatedMovementMode(SharedRepMovement.RepMovementMode);
+		GetCharacterMovement()->bNetworkMovementModeChanged = true;
+		GetCharacterMovement()->bNetworkUpdateReceived = true;
+	}
+
+	// Location, Rotation, Velocity. OnRep also sets LastRepMovement.
+	GetReplicatedMovement_Mutable() = SharedRepMovement.RepMovement;
+	OnRep_ReplicatedMovement();
+
+	SetProxyIsJumpForceApplied(SharedRepMovement.bProxyIsJumpForceApplied);
+
+	if (IsCrouched() != SharedRepMovement.bIsCrouched)
+	{
+		SetIsCrouched(SharedRepMovement.bIsCrouched);
+		OnRep_IsCrouched();
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
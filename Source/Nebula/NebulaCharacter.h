@@ -15,6 +15,48 @@ struct FInputActionValue;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
+/**
+ * Movement sent through the replication graph's FastShared path. Serialized once per character per frame and the same bunch is sent to every
+ * connection the graph gathers the character for, instead of running the property replication of ReplicatedMovement per connection.
+ */
+USTRUCT()
+struct FSharedRepMovement
+{
+	GENERATED_BODY()
+
+	FSharedRepMovement();
+
+	bool FillForCharacter(ACharacter* Character);
+	bool Equals(const FSharedRepMovement& Other) const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	UPROPERTY(Transient)
+	FRepMovement RepMovement;
+
+	UPROPERTY(Transient)
+	float RepTimeStamp = 0.0f;
+
+	UPROPERTY(Transient)
+	uint8 RepMovementMode = 0;
+
+	UPROPERTY(Transient)
+	bool bProxyIsJumpForceApplied = false;
+
+	UPROPERTY(Transient)
+	bool bIsCrouched = false;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSharedRepMovement> : public TStructOpsTypeTraitsBase2<FSharedRepMovement>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithNetSharedSerialization = true,
+	};
+};
+
 UCLASS(config=Game)
 class ANebulaCharacter : public ACharacter
 {
@@ -46,6 +88,17 @@ class ANebulaCharacter : public ACharacter
 
 public:
 	ANebulaCharacter();
+
+	/** Called by the replication graph, at most once per frame, to send the FastShared movement update. Returns false if it can't be sent right now. */
+	bool UpdateSharedReplication();
+
+protected:
+	/** FastShared movement update. Only called through UpdateSharedReplication, the replication graph shares the resulting bunch across connections. */
+	UFUNCTION(NetMulticast, unreliable)
+	void FastSharedReplication(const FSharedRepMovement& SharedRepMovement);
+
+	// Last FastShared update, the RPC is only called again once it changes.
+	FSharedRepMovement LastSharedReplication;
 	
 
 protected:
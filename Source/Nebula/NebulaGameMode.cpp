@@ -2,6 +2,8 @@
 
 #include "NebulaGameMode.h"
 #include "NebulaCharacter.h"
+#include "System/NebulaPVSData.h"
+#include "System/NebulaPVSNetObjectFilter.h"
 #include "UObject/ConstructorHelpers.h"
 
 ANebulaGameMode::ANebulaGameMode()
@@ -13,3 +15,14 @@ ANebulaGameMode::ANebulaGameMode()
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
 }
+
+void ANebulaGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	// With Iris, PVS culling is done by the NetObjectFilter instead of the replication graph. The replication system exists once the server is listening.
+	if (UNebulaPVSNetObjectFilter* PVSFilter = UNebulaPVSNetObjectFilter::FindForWorld(GetWorld()))
+	{
+		PVSFilter->SetPVSData(UNebulaPVSDataAsset::FindForWorld(GetWorld()));
+	}
+}
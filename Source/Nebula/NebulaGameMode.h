@@ -13,6 +13,10 @@ class ANebulaGameMode : public AGameModeBase
 
 public:
 	ANebulaGameMode();
+
+	//~AGameModeBase interface
+	virtual void StartPlay() override;
+	//~End of AGameModeBase interface
 };
 
 
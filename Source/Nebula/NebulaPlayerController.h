@@ -13,5 +13,16 @@ UCLASS()
 class NEBULA_API ANebulaPlayerController : public APlayerController
 {
 	GENERATED_BODY()
-	
+
+public:
+	/** Players on the same team share PVS vision on the server (see Nebula.RepGraph.PVSTeamVision). INDEX_NONE for no team. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Team)
+	void SetTeamId(int32 NewTeamId) { TeamId = NewTeamId; }
+
+	UFUNCTION(BlueprintPure, Category = Team)
+	int32 GetTeamId() const { return TeamId; }
+
+private:
+	UPROPERTY(VisibleInstanceOnly, Category = Team)
+	int32 TeamId = INDEX_NONE;
 };
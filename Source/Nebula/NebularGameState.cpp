@@ -2,63 +2,155 @@
 
 
 #include "NebularGameState.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "System/NebulaPVSData.h"
+#include "System/NebulaReplicationGraph.h"
 #include "System/NebulaReplicationGraphSettings.h"
 
-void ANebularGameState::BeginPlay()
+#if !UE_BUILD_SHIPPING
+namespace Nebula::RepGraph
 {
-	Super::BeginPlay();
-	
-	
-	if (!HasAuthority())
+	int32 PVSDebugDraw = 0;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSDebugDraw(TEXT("Nebula.RepGraph.PVSDebugDraw"), PVSDebugDraw, TEXT("Draw the PVS cells around the local viewer. Cells visible from the viewer's cell are green, the viewer's cell is yellow."), ECVF_Cheat);
+
+	int32 PVSDebugDrawRadius = 8;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSDebugDrawRadius(TEXT("Nebula.RepGraph.PVSDebugDrawRadius"), PVSDebugDrawRadius, TEXT("Number of cells drawn on each side of the viewer's cell."), ECVF_Cheat);
+}
+#endif
+
+ANebularGameState::ANebularGameState()
+{
+#if !UE_BUILD_SHIPPING
+	// Only the debug draw ticks, and it early outs while the CVar is off.
+	PrimaryActorTick.bCanEverTick = true;
+#endif
+}
+
+void ANebularGameState::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+#if !UE_BUILD_SHIPPING
+	if (Nebula::RepGraph::PVSDebugDraw > 0 && GetNetMode() != NM_DedicatedServer)
 	{
-		if (const UNebulaReplicationGraphSettings* NebulaRepGraphSettings = GetDefault<UNebulaReplicationGraphSettings>())
-		{
-			const FVector2D SpatialBias(NebulaRepGraphSettings->PVSSpatialBiasX, NebulaRepGraphSettings->PVSSpatialBiasY);
-			DrawDebugGridCells(NebulaRepGraphSettings->PVSSCellSize, SpatialBias);
-		}
+		DrawDebugPVSCells();
 	}
+#endif
 }
 
-void ANebularGameState::DrawDebugGridCells(float InCellSize, const FVector2D& InSpatialBias)
+#if !UE_BUILD_SHIPPING
+void ANebularGameState::DrawDebugPVSCells()
 {
 	UWorld* World = GetWorld();
-	check(World);
+	APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+	AActor* ViewTarget = PC ? PC->GetViewTarget() : nullptr;
+	ULineBatchComponent* LineBatcher = World ? World->GetLineBatcher(UWorld::ELineBatcherType::World) : nullptr;
+	if (ViewTarget == nullptr || LineBatcher == nullptr)
+	{
+		return;
+	}
+
+	// Clients have no replication graph, so read the same baked asset the server loads. Maps without one only draw the grid from the settings.
+	if (!bDebugPVSDataLoaded)
+	{
+		bDebugPVSDataLoaded = true;
+		DebugPVSData = UNebulaPVSDataAsset::FindForWorld(World);
+		if (DebugPVSData && !DebugPVSData->IsBaked())
+		{
+			DebugPVSData = nullptr;
+		}
 
-	// $TODO : ⼱    DebugLine ׷.
-	// index ʿ, WorldLocation ʿϱ 
-	// ׷Ƿ SpatialBias  CellSize  ٽ WorldLocation ȯؾ.
-	/// -> CellSize ٽ ѵ, SpatialBias ٽ ؾ .
-	const int32 MaxX = (-InSpatialBias.X) * 2 / InCellSize;
-	const int32 MaxY = (-InSpatialBias.Y) * 2 / InCellSize;
+		if (DebugPVSData == nullptr)
+		{
+			UE_LOG(LogNebulaRepGraph, Display, TEXT("Nebula.RepGraph.PVSDebugDraw - no baked PVS data for this map, drawing the grid layout only."));
+		}
+	}
 
-	for (int32 X = 0; X <= MaxX; X++)
+	const UNebulaReplicationGraphSettings* NebulaRepGraphSettings = GetDefault<UNebulaReplicationGraphSettings>();
+	const float CellSize = DebugPVSData ? DebugPVSData->CellSize : NebulaRepGraphSettings->PVSSCellSize;
+	const FVector2D SpatialBias = DebugPVSData ? DebugPVSData->SpatialBias : FVector2D(NebulaRepGraphSettings->PVSSpatialBiasX, NebulaRepGraphSettings->PVSSpatialBiasY);
+	if (CellSize <= 0.f)
 	{
-		for (int32 Y = 0; Y <= MaxY; Y++)
+		return;
+	}
+
+	const FVector ViewLocation = ViewTarget->GetActorLocation();
+	const int32 ViewerX = FMath::FloorToInt32((ViewLocation.X - SpatialBias.X) / CellSize);
+	const int32 ViewerY = FMath::FloorToInt32((ViewLocation.Y - SpatialBias.Y) / CellSize);
+
+	const int32 Radius = FMath::Clamp(Nebula::RepGraph::PVSDebugDrawRadius, 0, 64);
+	int32 MinX = ViewerX - Radius;
+	int32 MinY = ViewerY - Radius;
+	int32 MaxX = ViewerX + Radius;
+	int32 MaxY = ViewerY + Radius;
+
+	const FNebulaPVSTable* Table = DebugPVSData ? &DebugPVSData->Table : nullptr;
+	if (Table)
+	{
+		MinX = FMath::Max(MinX, 0);
+		MinY = FMath::Max(MinY, 0);
+		MaxX = FMath::Min(MaxX, Table->GetNumX() - 1);
+		MaxY = FMath::Min(MaxY, Table->GetNumY() - 1);
+		if (MinX > MaxX || MinY > MaxY)
 		{
-			const FVector Center(((X * InCellSize) + InSpatialBias.X) + InCellSize / 2, ((Y * InCellSize) + InSpatialBias.Y) + InCellSize / 2, 10.f);
+			return;
+		}
+	}
 
-			const FVector TopLeft = Center + FVector(-InCellSize / 2, InCellSize / 2, 0.f);
-			const FVector TopRight = Center + FVector(InCellSize / 2, InCellSize / 2, 0.f);
+	const int32 ViewerCellIndex = (Table && Table->IsValidCell(ViewerX, ViewerY)) ? Table->GetCellIndex(ViewerX, ViewerY) : INDEX_NONE;
+	const float Z = ViewLocation.Z - ViewTarget->GetSimpleCollisionHalfHeight() + 10.f;
+	auto CellCorner = [&](int32 X, int32 Y) { return FVector(SpatialBias.X + X * CellSize, SpatialBias.Y + Y * CellSize, Z); };
 
-			const FVector BottomLeft = Center + FVector(-InCellSize / 2, -InCellSize / 2, 0.f);
-			const FVector BottomRight = Center + FVector(InCellSize / 2, -InCellSize / 2, 0.f);
+	// Everything goes through one DrawLines call. Lifetime 0 on the world batcher lasts a single frame, so nothing accumulates.
+	TArray<FBatchedLine> Lines;
+	Lines.Reserve((MaxX - MinX + 2) + (MaxY - MinY + 2) + (MaxX - MinX + 1) * (MaxY - MinY + 1) * 4);
 
-			if (X == 0 && Y == 0)
-			{
-				DrawDebugLine(World, TopLeft, BottomRight, FColor::Black, true, -1.f, 0U, 10.f);
-				DrawDebugLine(World, TopRight, BottomLeft, FColor::White, true, -1.f, 0U, 10.f);
-			}
+	for (int32 X = MinX; X <= MaxX + 1; ++X)
+	{
+		Lines.Emplace(CellCorner(X, MinY), CellCorner(X, MaxY + 1), FLinearColor(FColor::Silver), 0.f, 1.f, SDPG_World);
+	}
+	for (int32 Y = MinY; Y <= MaxY + 1; ++Y)
+	{
+		Lines.Emplace(CellCorner(MinX, Y), CellCorner(MaxX + 1, Y), FLinearColor(FColor::Silver), 0.f, 1.f, SDPG_World);
+	}
+
+	// Inset, so highlighted neighbours don't share an edge.
+	const FVector Inset(CellSize * 0.05f, CellSize * 0.05f, 0.f);
+	auto AddCell = [&](int32 X, int32 Y, int32 Span, const FLinearColor& Color)
+		{
+			const FVector Min = CellCorner(X, Y) + Inset;
+			const FVector Max = CellCorner(X + Span, Y + Span) - Inset;
+			const FVector MinMax(Min.X, Max.Y, Z);
+			const FVector MaxMin(Max.X, Min.Y, Z);
+			Lines.Emplace(Min, MinMax, Color, 0.f, 4.f, SDPG_World);
+			Lines.Emplace(MinMax, Max, Color, 0.f, 4.f, SDPG_World);
+			Lines.Emplace(Max, MaxMin, Color, 0.f, 4.f, SDPG_World);
+			Lines.Emplace(MaxMin, Min, Color, 0.f, 4.f, SDPG_World);
+		};
 
-			if (X == MaxX && Y == MaxY)
+	if (ViewerCellIndex != INDEX_NONE)
+	{
+		// Walks the runs of the row and keeps what falls in the drawn window.
+		Table->ForEachVisibleCell(ViewerCellIndex, [&](int32 CellIndex)
 			{
-				DrawDebugLine(World, TopLeft, BottomRight, FColor::Black, true, -1.f, 0U, 10.f);
-				DrawDebugLine(World, TopRight, BottomLeft, FColor::White, true, -1.f, 0U, 10.f);
-			}
-
-			DrawDebugLine(World, TopLeft, TopRight, FColor::Red, true, -1.f, 0U, 2.f);
-			DrawDebugLine(World, TopLeft, BottomLeft, FColor::Green, true, -1.f, 0U, 2.f);
-			DrawDebugLine(World, BottomRight, TopRight, FColor::Blue, true, -1.f, 0U, 2.f);
-			DrawDebugLine(World, BottomRight, BottomLeft, FColor::Yellow, true, -1.f, 0U, 2.f);
-		}
+				const FIntPoint Cell = Table->GetCell(CellIndex);
+				if (Cell.X >= MinX && Cell.X <= MaxX && Cell.Y >= MinY && Cell.Y <= MaxY && CellIndex != ViewerCellIndex)
+				{
+					AddCell(Cell.X, Cell.Y, Table->GetCellSpan(CellIndex), FLinearColor::Green);
+				}
+			});
 	}
+
+	if (ViewerX >= MinX && ViewerX <= MaxX && ViewerY >= MinY && ViewerY <= MaxY)
+	{
+		// Coarse cells of two-level tables are drawn whole.
+		const FIntPoint ViewerCell = ViewerCellIndex != INDEX_NONE ? Table->GetCellOrigin(ViewerX, ViewerY) : FIntPoint(ViewerX, ViewerY);
+		AddCell(ViewerCell.X, ViewerCell.Y, ViewerCellIndex != INDEX_NONE ? Table->GetCellSpanAt(ViewerX, ViewerY) : 1, FLinearColor::Yellow);
+	}
+
+	LineBatcher->DrawLines(Lines);
 }
+#endif
@@ -6,6 +6,8 @@
 #include "GameFramework/GameStateBase.h"
 #include "NebularGameState.generated.h"
 
+class UNebulaPVSDataAsset;
+
 /**
  * 
  */
@@ -13,10 +15,21 @@ UCLASS()
 class NEBULA_API ANebularGameState : public AGameStateBase
 {
 	GENERATED_BODY()
-	
-protected:
-	virtual void BeginPlay() override;
+
+public:
+	ANebularGameState();
+
+	virtual void Tick(float DeltaSeconds) override;
 
 private:
-	void DrawDebugGridCells(const float InCellSize, const FVector2D& InSpatialBias);
+#if !UE_BUILD_SHIPPING
+	// Draws the PVS cells around the local viewer when Nebula.RepGraph.PVSDebugDraw is set. Cells visible from the viewer's cell are highlighted.
+	void DrawDebugPVSCells();
+
+	bool bDebugPVSDataLoaded = false;
+#endif
+
+	// Baked table the PVS debug draw colours cells from. Loaded on first use, null if the map has none.
+	UPROPERTY(Transient)
+	TObjectPtr<const UNebulaPVSDataAsset> DebugPVSData;
 };
@@ -0,0 +1,36 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "NebulaCellMath.h"
+
+void FNebulaCellMapping::GetCells(TConstArrayView<FVector> Locations, TArrayView<FNebulaCellId> OutCells) const
+{
+	check(OutCells.Num() >= Locations.Num());
+
+	const int32 Num = Locations.Num();
+	const FVector* RESTRICT Src = Locations.GetData();
+	FNebulaCellId* RESTRICT Dst = OutCells.GetData();
+
+	// Lanes are {X0, Y0, X1, Y1}. Bias is subtracted in double so large world coordinates keep their precision,
+	// the cell-relative result comfortably fits a float before the convert.
+	const VectorRegister4Double Bias = MakeVectorRegisterDouble(SpatialBias.X, SpatialBias.Y, SpatialBias.X, SpatialBias.Y);
+	const VectorRegister4Double Scale = MakeVectorRegisterDouble(InvCellSize, InvCellSize, InvCellSize, InvCellSize);
+
+	int32 Index = 0;
+	for (; Index + 1 < Num; Index += 2)
+	{
+		const VectorRegister4Double XY = MakeVectorRegisterDouble(Src[Index].X, Src[Index].Y, Src[Index + 1].X, Src[Index + 1].Y);
+		const VectorRegister4Double Local = VectorFloor(VectorMultiply(VectorSubtract(XY, Bias), Scale));
+
+		alignas(16) int32 Cells[4];
+		VectorIntStoreAligned(VectorFloatToInt(MakeVectorRegisterFloatFromDouble(Local)), Cells);
+
+		Dst[Index] = MakeCell(Cells[0], Cells[1]);
+		Dst[Index + 1] = MakeCell(Cells[2], Cells[3]);
+	}
+
+	for (; Index < Num; ++Index)
+	{
+		Dst[Index] = GetCell(Src[Index]);
+	}
+}
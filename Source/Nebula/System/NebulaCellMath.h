@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* 2D grid cell packed into 32 bits : signed 16-bit X in the high half, signed 16-bit Y in the low half.
+* Half the size of an FIntPoint and comparable/hashable as one integer. Coordinates saturate to +-32767, which is
+* far outside of any PVS table, so out of range cells stay out of range.
+*/
+struct FNebulaCellId
+{
+	FNebulaCellId() = default;
+	FNebulaCellId(int32 X, int32 Y)
+		: Packed(((uint32)(uint16)(int16)FMath::Clamp(X, -MaxCoord, MaxCoord) << 16) | (uint32)(uint16)(int16)FMath::Clamp(Y, -MaxCoord, MaxCoord))
+	{
+	}
+
+	int32 GetX() const { return (int16)(Packed >> 16); }
+	int32 GetY() const { return (int16)(Packed & 0xFFFF); }
+
+	// Not bucketed yet. Can't be produced from a location.
+	bool IsValid() const { return Packed != InvalidValue; }
+	void Reset() { Packed = InvalidValue; }
+
+	// Catch-all cell for locations outside of the mapping bounds. @see FNebulaCellMapping::Init
+	static FNebulaCellId Overflow() { FNebulaCellId CellId; CellId.Packed = OverflowValue; return CellId; }
+	bool IsOverflow() const { return Packed == OverflowValue; }
+
+	bool operator==(const FNebulaCellId& Other) const { return Packed == Other.Packed; }
+	bool operator!=(const FNebulaCellId& Other) const { return Packed != Other.Packed; }
+	friend uint32 GetTypeHash(const FNebulaCellId& CellId) { return CellId.Packed; }
+
+	FString ToString() const { return IsOverflow() ? FString(TEXT("{Overflow}")) : FString::Printf(TEXT("{%d, %d}"), GetX(), GetY()); }
+
+private:
+	static constexpr int32 MaxCoord = MAX_int16;
+	static constexpr uint32 InvalidValue = 0x80008000;	// {-32768, -32768}
+	static constexpr uint32 OverflowValue = 0x80007FFF;	// {-32768, 32767}
+
+	uint32 Packed = InvalidValue;
+};
+
+/**
+* Location -> 2D grid cell mapping with a precomputed reciprocal cell size.
+* Cells are floored, so locations just below the bias don't collapse into cell 0.
+* With bounds set, everything outside of [0, Bounds) maps to FNebulaCellId::Overflow() instead of growing or clamping the grid.
+* Used by the PVS grid node for both single lookups (viewers, static actors) and the per-frame batch of dynamic actors.
+*/
+struct NEBULA_API FNebulaCellMapping
+{
+	/** InBounds of zero means unbounded. */
+	void Init(const FVector2D& InSpatialBias, float InCellSize, const FIntPoint& InBounds = FIntPoint::ZeroValue)
+	{
+		SpatialBias = InSpatialBias;
+		CellSize = InCellSize;
+		InvCellSize = InCellSize > 0.f ? 1.0 / InCellSize : 0.0;
+		Bounds = InBounds;
+	}
+
+	FNebulaCellId GetCell(const FVector& Location) const
+	{
+		return MakeCell(FMath::FloorToInt32((Location.X - SpatialBias.X) * InvCellSize), FMath::FloorToInt32((Location.Y - SpatialBias.Y) * InvCellSize));
+	}
+
+	/** True if Location is inside the Span x Span cells starting at Cell, grown by Margin on every side. Cell must not be invalid or overflow. */
+	bool IsInsideCell(const FVector& Location, FNebulaCellId Cell, double Margin, int32 Span = 1) const
+	{
+		const double MinX = SpatialBias.X + Cell.GetX() * CellSize - Margin;
+		const double MinY = SpatialBias.Y + Cell.GetY() * CellSize - Margin;
+		const double Extent = Span * CellSize + 2.0 * Margin;
+		return Location.X >= MinX && Location.X < MinX + Extent && Location.Y >= MinY && Location.Y < MinY + Extent;
+	}
+
+	/** Batch version of GetCell. OutCells must be at least as large as Locations. Vectorized two locations at a time. */
+	void GetCells(TConstArrayView<FVector> Locations, TArrayView<FNebulaCellId> OutCells) const;
+
+private:
+	FNebulaCellId MakeCell(int32 X, int32 Y) const
+	{
+		if (Bounds.X > 0 && ((uint32)X >= (uint32)Bounds.X || (uint32)Y >= (uint32)Bounds.Y))
+		{
+			return FNebulaCellId::Overflow();
+		}
+		return FNebulaCellId(X, Y);
+	}
+
+	FVector2D SpatialBias = FVector2D::ZeroVector;
+	double CellSize = 0.0;
+	double InvCellSize = 0.0;
+	FIntPoint Bounds = FIntPoint::ZeroValue;
+};
@@ -0,0 +1,481 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "NebulaPVSData.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/Unique.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "NebulaReplicationGraph.h"
+#include "NebulaReplicationGraphSettings.h"
+
+void FNebulaPVSTable::Init(int32 InNumX, int32 InNumY)
+{
+	Reset();
+	NumX = InNumX;
+	NumY = InNumY;
+	RowOffsets.Reserve(GetNumCells() + 1);
+	RowOffsets.Add(0);
+}
+
+void FNebulaPVSTable::InitBlocks(int32 InNumX, int32 InNumY, int32 InBlockSize, TConstArrayView<bool> SubdividedBlocks)
+{
+	if (InBlockSize <= 1)
+	{
+		Init(InNumX, InNumY);
+		return;
+	}
+
+	Reset();
+	NumX = InNumX;
+	NumY = InNumY;
+	BlockSize = InBlockSize;
+	check(SubdividedBlocks.Num() == GetNumBlocksX() * GetNumBlocksY());
+
+	// Blocks are laid out in block index order, and the cells of a subdivided block in the same X-major order as a uniform table.
+	int32 NumCells = 0;
+	BlockFirstCell.Reserve(SubdividedBlocks.Num() + 1);
+	for (const bool bSubdivided : SubdividedBlocks)
+	{
+		BlockFirstCell.Add(NumCells);
+		NumCells += bSubdivided ? BlockSize * BlockSize : 1;
+	}
+	BlockFirstCell.Add(NumCells);
+
+	RowOffsets.Reserve(NumCells + 1);
+	RowOffsets.Add(0);
+}
+
+void FNebulaPVSTable::Reset()
+{
+	NumX = 0;
+	NumY = 0;
+	BlockSize = 1;
+	RowOffsets.Reset();
+	Runs.Reset();
+	BlockFirstCell.Reset();
+}
+
+FIntPoint FNebulaPVSTable::GetCell(int32 CellIndex) const
+{
+	if (!IsHierarchical())
+	{
+		return FIntPoint(CellIndex / NumY, CellIndex % NumY);
+	}
+
+	const int32 BlockIndex = Algo::UpperBound(BlockFirstCell, CellIndex) - 1;
+	const int32 NumBlocksY = GetNumBlocksY();
+	const int32 LocalIndex = CellIndex - BlockFirstCell[BlockIndex];
+	return FIntPoint((BlockIndex / NumBlocksY) * BlockSize + LocalIndex / BlockSize, (BlockIndex % NumBlocksY) * BlockSize + LocalIndex % BlockSize);
+}
+
+int32 FNebulaPVSTable::GetCellSpan(int32 CellIndex) const
+{
+	if (!IsHierarchical())
+	{
+		return 1;
+	}
+
+	const int32 BlockIndex = Algo::UpperBound(BlockFirstCell, CellIndex) - 1;
+	return IsBlockSubdivided(BlockIndex) ? 1 : BlockSize;
+}
+
+void FNebulaPVSTable::AddRun(int32 Length)
+{
+	// Split runs longer than uint16 with an empty run of the other kind, so runs keep alternating.
+	while (Length > MAX_uint16)
+	{
+		Runs.Add(MAX_uint16);
+		Runs.Add(0);
+		Length -= MAX_uint16;
+	}
+	Runs.Add((uint16)Length);
+}
+
+void FNebulaPVSTable::AppendRow(TConstArrayView<int32> SortedVisibleCells)
+{
+	check(RowOffsets.Num() > 0 && GetNumRows() < GetNumCells());
+
+	int32 Cursor = 0;
+	for (int32 i = 0; i < SortedVisibleCells.Num(); )
+	{
+		const int32 SetStart = SortedVisibleCells[i];
+		checkSlow(SetStart >= Cursor && SetStart < GetNumCells());
+
+		int32 SetEnd = SetStart + 1;
+		for (++i; i < SortedVisibleCells.Num() && SortedVisibleCells[i] == SetEnd; ++i)
+		{
+			++SetEnd;
+		}
+
+		AddRun(SetStart - Cursor);
+		AddRun(SetEnd - SetStart);
+		Cursor = SetEnd;
+	}
+
+	RowOffsets.Add(Runs.Num());
+}
+
+bool FNebulaPVSTable::IsVisible(int32 SourceCellIndex, int32 TargetCellIndex) const
+{
+	int32 Cursor = 0;
+	const int32 RowEnd = RowOffsets[SourceCellIndex + 1];
+	for (int32 RunIdx = RowOffsets[SourceCellIndex]; RunIdx + 1 < RowEnd; RunIdx += 2)
+	{
+		Cursor += Runs[RunIdx];
+		if (TargetCellIndex < Cursor)
+		{
+			return false;
+		}
+
+		Cursor += Runs[RunIdx + 1];
+		if (TargetCellIndex < Cursor)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int32 FNebulaPVSTable::GetNumVisibleCells(int32 SourceCellIndex) const
+{
+	int32 Count = 0;
+	const int32 RowEnd = RowOffsets[SourceCellIndex + 1];
+	for (int32 RunIdx = RowOffsets[SourceCellIndex] + 1; RunIdx < RowEnd; RunIdx += 2)
+	{
+		Count += Runs[RunIdx];
+	}
+	return Count;
+}
+
+bool FNebulaPVSTable::IsConsistent() const
+{
+	if (IsHierarchical())
+	{
+		const int32 NumBlocks = GetNumBlocksX() * GetNumBlocksY();
+		if (BlockFirstCell.Num() != NumBlocks + 1 || BlockFirstCell[0] != 0)
+		{
+			return false;
+		}
+
+		for (int32 BlockIndex = 0; BlockIndex < NumBlocks; ++BlockIndex)
+		{
+			const int32 NumBlockCells = BlockFirstCell[BlockIndex + 1] - BlockFirstCell[BlockIndex];
+			if (NumBlockCells != 1 && NumBlockCells != BlockSize * BlockSize)
+			{
+				return false;
+			}
+		}
+	}
+	else if (BlockSize < 1 || BlockFirstCell.Num() > 0)
+	{
+		return false;
+	}
+
+	const int32 NumCells = GetNumCells();
+	if (NumCells <= 0 || RowOffsets.Num() != NumCells + 1 || RowOffsets[0] != 0 || RowOffsets.Last() != Runs.Num())
+	{
+		return false;
+	}
+
+	for (int32 Row = 0; Row < NumCells; ++Row)
+	{
+		const int32 RowEnd = RowOffsets[Row + 1];
+		if (RowEnd < RowOffsets[Row])
+		{
+			return false;
+		}
+
+		int32 Cursor = 0;
+		for (int32 RunIdx = RowOffsets[Row]; RunIdx < RowEnd; ++RunIdx)
+		{
+			Cursor += Runs[RunIdx];
+		}
+
+		if (Cursor > NumCells)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+UNebulaPVSDataAsset* UNebulaPVSDataAsset::FindForWorld(const UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return nullptr;
+	}
+
+	const UNebulaReplicationGraphSettings* NebulaRepGraphSettings = GetDefault<UNebulaReplicationGraphSettings>();
+	const FString MapPackageName = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+
+	for (const TPair<TSoftObjectPtr<UWorld>, TSoftObjectPtr<UNebulaPVSDataAsset>>& It : NebulaRepGraphSettings->PVSDataPerMap)
+	{
+		if (It.Key.ToSoftObjectPath().GetLongPackageName() == MapPackageName)
+		{
+			return It.Value.LoadSynchronous();
+		}
+	}
+
+	return nullptr;
+}
+
+#if WITH_EDITOR
+void UNebulaPVSDataAsset::Bake(UWorld* World, const FBox2D* DirtyRegion)
+{
+	check(World);
+
+	if (GridSize.X <= 0 || GridSize.Y <= 0 || CellSize <= 0.f || SamplePoints.Num() == 0 || SampleHeights.Num() == 0)
+	{
+		UE_LOG(LogNebulaRepGraph, Error, TEXT("UNebulaPVSDataAsset::Bake - %s has an invalid grid or no sample points."), *GetName());
+		return;
+	}
+
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(NebulaPVSBake), true);
+	const ECollisionChannel Channel = TraceChannel;
+
+	// Cell layout. A block with nothing blocking at the sample heights sees the same from all of its cells, so it is baked as one coarse cell.
+	FNebulaPVSTable NewTable;
+	if (BlockSize > 1)
+	{
+		const int32 NumBlocksY = FMath::DivideAndRoundUp(GridSize.Y, BlockSize);
+		const int32 NumBlocks = FMath::DivideAndRoundUp(GridSize.X, BlockSize) * NumBlocksY;
+		const float MinHeight = FMath::Min(SampleHeights);
+		const float MaxHeight = FMath::Max(SampleHeights);
+		const FCollisionShape BlockShape = FCollisionShape::MakeBox(FVector(BlockSize * CellSize * 0.5f, BlockSize * CellSize * 0.5f, FMath::Max((MaxHeight - MinHeight) * 0.5f, 1.f)));
+
+		TArray<bool> SubdividedBlocks;
+		SubdividedBlocks.SetNumZeroed(NumBlocks);
+		ParallelFor(NumBlocks, [&](int32 BlockIndex)
+			{
+				const FVector2D BlockCenter = SpatialBias + (FVector2D(BlockIndex / NumBlocksY, BlockIndex % NumBlocksY) + 0.5) * BlockSize * CellSize;
+				SubdividedBlocks[BlockIndex] = World->OverlapBlockingTestByChannel(FVector(BlockCenter, (MinHeight + MaxHeight) * 0.5f), FQuat::Identity, Channel, BlockShape, QueryParams);
+			});
+
+		NewTable.InitBlocks(GridSize.X, GridSize.Y, BlockSize, SubdividedBlocks);
+	}
+	else
+	{
+		NewTable.Init(GridSize.X, GridSize.Y);
+	}
+
+	const int32 NumCells = NewTable.GetNumCells();
+
+	// Re-trace only pairs touching the dirty region. Anything else of the cell layout changing needs a full bake.
+	const bool bIncremental = (DirtyRegion != nullptr) && IsBaked() && Table.HasSameLayout(NewTable);
+
+	TBitArray<> DirtyCells(!bIncremental, NumCells);
+	if (bIncremental)
+	{
+		const int32 MinX = FMath::Clamp(FMath::FloorToInt32((DirtyRegion->Min.X - SpatialBias.X) / CellSize), 0, GridSize.X - 1);
+		const int32 MinY = FMath::Clamp(FMath::FloorToInt32((DirtyRegion->Min.Y - SpatialBias.Y) / CellSize), 0, GridSize.Y - 1);
+		const int32 MaxX = FMath::Clamp(FMath::FloorToInt32((DirtyRegion->Max.X - SpatialBias.X) / CellSize), 0, GridSize.X - 1);
+		const int32 MaxY = FMath::Clamp(FMath::FloorToInt32((DirtyRegion->Max.Y - SpatialBias.Y) / CellSize), 0, GridSize.Y - 1);
+
+		for (int32 X = MinX; X <= MaxX; ++X)
+		{
+			for (int32 Y = MinY; Y <= MaxY; ++Y)
+			{
+				DirtyCells[NewTable.GetCellIndex(X, Y)] = true;
+			}
+		}
+	}
+
+	// Min grid coordinate and width of every cell.
+	TArray<FIntPoint> CellOrigins;
+	TArray<int32> CellSpans;
+	CellOrigins.SetNumUninitialized(NumCells);
+	CellSpans.SetNumUninitialized(NumCells);
+	for (int32 CellIndex = 0; CellIndex < NumCells; ++CellIndex)
+	{
+		CellOrigins[CellIndex] = NewTable.GetCell(CellIndex);
+		CellSpans[CellIndex] = NewTable.GetCellSpan(CellIndex);
+	}
+
+	// World space sample points of every cell.
+	const int32 NumSamples = SamplePoints.Num() * SampleHeights.Num();
+	TArray<FVector> CellSamples;
+	CellSamples.SetNumUninitialized(NumCells * NumSamples);
+
+	for (int32 CellIndex = 0; CellIndex < NumCells; ++CellIndex)
+	{
+		const FVector2D CellMin = SpatialBias + FVector2D(CellOrigins[CellIndex]) * CellSize;
+		const float CellExtent = CellSpans[CellIndex] * CellSize;
+
+		int32 SampleIdx = CellIndex * NumSamples;
+		for (const float Height : SampleHeights)
+		{
+			for (const FVector2D& SamplePoint : SamplePoints)
+			{
+				CellSamples[SampleIdx++] = FVector(CellMin + SamplePoint * CellExtent, Height);
+			}
+		}
+	}
+
+	const int32 MaxCellRange = MaxVisibleDistance > 0.f ? FMath::CeilToInt32(MaxVisibleDistance / CellSize) : FMath::Max(GridSize.X, GridSize.Y);
+
+	auto AreCellsVisible = [&](int32 SourceIndex, int32 TargetIndex)
+		{
+			const FVector* SourceSamples = &CellSamples[SourceIndex * NumSamples];
+			const FVector* TargetSamples = &CellSamples[TargetIndex * NumSamples];
+
+			for (int32 i = 0; i < NumSamples; ++i)
+			{
+				for (int32 j = 0; j < NumSamples; ++j)
+				{
+					if (!World->LineTraceTestByChannel(SourceSamples[i], TargetSamples[j], Channel, QueryParams))
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		};
+
+	// Closest distance, in grid cells, between the centers of any grid cell of one and any grid cell of the other. Same as the center distance for single cells,
+	// while a coarse block is kept if any part of it is in range, like its samples spread over the whole block.
+	auto GetCenterDistSquared = [&](int32 IndexA, int32 IndexB)
+		{
+			auto AxisGap = [](int32 OriginA, int32 SpanA, int32 OriginB, int32 SpanB)
+				{
+					return FMath::Max3(0, OriginB - (OriginA + SpanA - 1), OriginA - (OriginB + SpanB - 1));
+				};
+
+			const FIntPoint A = CellOrigins[IndexA];
+			const FIntPoint B = CellOrigins[IndexB];
+			return FVector2D(AxisGap(A.X, CellSpans[IndexA], B.X, CellSpans[IndexB]), AxisGap(A.Y, CellSpans[IndexA], B.Y, CellSpans[IndexB])).SizeSquared();
+		};
+
+	TArray<TArray<int32>> NewRows;
+	NewRows.SetNum(NumCells);
+
+	// Pairs traced by each row, to be mirrored into the other row afterwards.
+	TArray<TArray<int32>> TracedPairs;
+	TracedPairs.SetNum(NumCells);
+
+	// Scene queries are safe from worker threads as long as nothing modifies the physics scene, which holds while the editor is blocked on the bake.
+	ParallelFor(NumCells, [&](int32 RowIndex)
+		{
+			const FIntPoint Source = CellOrigins[RowIndex];
+			const int32 SourceSpan = CellSpans[RowIndex];
+			TArray<int32>& VisibleCells = NewRows[RowIndex];
+
+			if (bIncremental)
+			{
+				Table.ForEachVisibleCell(RowIndex, [&](int32 TargetIndex)
+					{
+						if (!DirtyCells[RowIndex] && !DirtyCells[TargetIndex])
+						{
+							VisibleCells.Add(TargetIndex);
+						}
+					});
+			}
+
+			// Cells within range of any grid cell of the source. Coarse cells are hit once per grid row they span, hence the sort.
+			TArray<int32> Candidates;
+			const int32 MinX = FMath::Max(Source.X - MaxCellRange, 0);
+			const int32 MaxX = FMath::Min(Source.X + SourceSpan - 1 + MaxCellRange, GridSize.X - 1);
+			const int32 MinY = FMath::Max(Source.Y - MaxCellRange, 0);
+			const int32 MaxY = FMath::Min(Source.Y + SourceSpan - 1 + MaxCellRange, GridSize.Y - 1);
+
+			for (int32 X = MinX; X <= MaxX; ++X)
+			{
+				for (int32 Y = MinY; Y <= MaxY; ++Y)
+				{
+					const int32 TargetIndex = NewTable.GetCellIndex(X, Y);
+
+					// Skip the rest of a coarse cell's column.
+					Y = FMath::Max(Y, NewTable.GetCellOrigin(X, Y).Y + CellSpans[TargetIndex] - 1);
+
+					// Visibility is symmetric, so each pair is only traced by its lower row.
+					if (TargetIndex >= RowIndex)
+					{
+						Candidates.Add(TargetIndex);
+					}
+				}
+			}
+			Candidates.Sort();
+			Candidates.SetNum(Algo::Unique(Candidates));
+
+			for (const int32 TargetIndex : Candidates)
+			{
+				if (!DirtyCells[RowIndex] && !DirtyCells[TargetIndex])
+				{
+					continue;
+				}
+
+				if (MaxVisibleDistance > 0.f && GetCenterDistSquared(RowIndex, TargetIndex) * FMath::Square(CellSize) > FMath::Square(MaxVisibleDistance))
+				{
+					continue;
+				}
+
+				if (TargetIndex == RowIndex)
+				{
+					VisibleCells.Add(RowIndex);
+				}
+				else if (AreCellsVisible(RowIndex, TargetIndex))
+				{
+					VisibleCells.Add(TargetIndex);
+					TracedPairs[RowIndex].Add(TargetIndex);
+				}
+			}
+		});
+
+	for (int32 RowIndex = 0; RowIndex < NumCells; ++RowIndex)
+	{
+		for (const int32 TargetIndex : TracedPairs[RowIndex])
+		{
+			NewRows[TargetIndex].Add(RowIndex);
+		}
+	}
+
+	ParallelFor(NumCells, [&](int32 RowIndex)
+		{
+			NewRows[RowIndex].Sort();
+		});
+
+	for (const TArray<int32>& Row : NewRows)
+	{
+		NewTable.AppendRow(Row);
+	}
+	Table = MoveTemp(NewTable);
+	MarkPackageDirty();
+
+	UE_LOG(LogNebulaRepGraph, Display, TEXT("UNebulaPVSDataAsset::Bake - %s baked %d cells for a %dx%d grid (%s), %llu bytes."),
+		*GetName(), NumCells, GridSize.X, GridSize.Y, bIncremental ? TEXT("incremental") : TEXT("full"), (uint64)Table.GetAllocatedSize());
+}
+
+FAutoConsoleCommandWithWorldAndArgs NebulaPVSBakeCmd(TEXT("Nebula.PVS.Bake"), TEXT("Bakes the PVS asset of the current world. Usage: Nebula.PVS.Bake [AssetPath] [DirtyMinX DirtyMinY DirtyMaxX DirtyMaxY]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			int32 ArgIdx = 0;
+
+			UNebulaPVSDataAsset* PVSData = nullptr;
+			if (Args.IsValidIndex(ArgIdx) && !Args[ArgIdx].IsNumeric())
+			{
+				PVSData = LoadObject<UNebulaPVSDataAsset>(nullptr, *Args[ArgIdx++]);
+			}
+			else
+			{
+				PVSData = UNebulaPVSDataAsset::FindForWorld(World);
+			}
+
+			if (PVSData == nullptr || World == nullptr)
+			{
+				UE_LOG(LogNebulaRepGraph, Error, TEXT("Nebula.PVS.Bake - No PVS asset found. Pass an asset path or add the map to PVSDataPerMap."));
+				return;
+			}
+
+			if (Args.Num() - ArgIdx >= 4)
+			{
+				const FBox2D DirtyRegion(FVector2D(FCString::Atof(*Args[ArgIdx]), FCString::Atof(*Args[ArgIdx + 1])), FVector2D(FCString::Atof(*Args[ArgIdx + 2]), FCString::Atof(*Args[ArgIdx + 3])));
+				PVSData->Bake(World, &DirtyRegion);
+			}
+			else
+			{
+				PVSData->Bake(World);
+			}
+		}));
+#endif
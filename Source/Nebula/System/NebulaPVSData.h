@@ -0,0 +1,200 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/EngineTypes.h"
+#include "NebulaPVSData.generated.h"
+
+/**
+* Compact visibility table: one run-length encoded bit-row per source cell, bit N of a row is set if cell N is visible from the source.
+* Cells are addressed by a flat index X * NumY + Y, so a lookup is a single contiguous row fetch without hashing.
+* Runs alternate clear/set starting with clear. Visible sets are spatially coherent, so a row is usually a few runs per visible column.
+*
+* Two-level tables group the grid into blocks of BlockSize x BlockSize cells. A block is either one coarse cell (open terrain, where every cell
+* of the block sees the same) or subdivided into one cell per grid cell. Rows and their bits are per cell of that layout, so a "cell index" is
+* the index of the coarse or fine cell a grid coordinate falls in, and GetNumCells() counts those rather than NumX * NumY.
+*/
+USTRUCT()
+struct NEBULA_API FNebulaPVSTable
+{
+	GENERATED_BODY()
+
+	void Init(int32 InNumX, int32 InNumY);
+	/** Two-level layout. SubdividedBlocks has one entry per block, in block index order (BlockX * NumBlocksY + BlockY). */
+	void InitBlocks(int32 InNumX, int32 InNumY, int32 InBlockSize, TConstArrayView<bool> SubdividedBlocks);
+	void Reset();
+
+	int32 GetNumX() const { return NumX; }
+	int32 GetNumY() const { return NumY; }
+	int32 GetNumCells() const { return IsHierarchical() ? (BlockFirstCell.Num() > 0 ? BlockFirstCell.Last() : 0) : NumX * NumY; }
+	int32 GetNumRows() const { return RowOffsets.Num() > 0 ? RowOffsets.Num() - 1 : 0; }
+
+	bool IsHierarchical() const { return BlockSize > 1; }
+	int32 GetBlockSize() const { return BlockSize; }
+	int32 GetNumBlocksX() const { return FMath::DivideAndRoundUp(NumX, BlockSize); }
+	int32 GetNumBlocksY() const { return FMath::DivideAndRoundUp(NumY, BlockSize); }
+	int32 GetBlockIndex(int32 X, int32 Y) const { return (X / BlockSize) * GetNumBlocksY() + (Y / BlockSize); }
+	bool IsBlockSubdivided(int32 BlockIndex) const { return BlockFirstCell[BlockIndex + 1] - BlockFirstCell[BlockIndex] > 1; }
+
+	/** Same cells, rows aside. Lists and grid nodes keyed by cell index stay valid across tables with the same layout. */
+	bool HasSameLayout(const FNebulaPVSTable& Other) const { return NumX == Other.NumX && NumY == Other.NumY && BlockSize == Other.BlockSize && BlockFirstCell == Other.BlockFirstCell; }
+
+	bool IsValidCell(int32 X, int32 Y) const { return X >= 0 && Y >= 0 && X < NumX && Y < NumY; }
+
+	/** Index of the cell grid coordinate X, Y falls in. */
+	int32 GetCellIndex(int32 X, int32 Y) const
+	{
+		if (!IsHierarchical())
+		{
+			return X * NumY + Y;
+		}
+
+		const int32 BlockIndex = GetBlockIndex(X, Y);
+		const int32 FirstCell = BlockFirstCell[BlockIndex];
+		return IsBlockSubdivided(BlockIndex) ? FirstCell + (X % BlockSize) * BlockSize + (Y % BlockSize) : FirstCell;
+	}
+
+	/** Min grid coordinate of a cell. Binary searches the blocks of two-level tables, prefer GetCellOrigin when the grid coordinate is known. */
+	FIntPoint GetCell(int32 CellIndex) const;
+
+	/** Min grid coordinate of the cell X, Y falls in. Locations in one cell all map to the same origin, which makes it usable as a cell id. */
+	FIntPoint GetCellOrigin(int32 X, int32 Y) const
+	{
+		if (IsHierarchical() && !IsBlockSubdivided(GetBlockIndex(X, Y)))
+		{
+			return FIntPoint(X - X % BlockSize, Y - Y % BlockSize);
+		}
+		return FIntPoint(X, Y);
+	}
+
+	/** Width of a cell in grid cells: BlockSize for coarse cells, 1 otherwise. */
+	int32 GetCellSpan(int32 CellIndex) const;
+	int32 GetCellSpanAt(int32 X, int32 Y) const { return IsHierarchical() && !IsBlockSubdivided(GetBlockIndex(X, Y)) ? BlockSize : 1; }
+
+	/** Appends the row of the next source cell. SortedVisibleCells must be sorted and unique. Rows must be appended in cell index order. */
+	void AppendRow(TConstArrayView<int32> SortedVisibleCells);
+
+	bool IsVisible(int32 SourceCellIndex, int32 TargetCellIndex) const;
+	int32 GetNumVisibleCells(int32 SourceCellIndex) const;
+	int32 GetNumRuns(int32 SourceCellIndex) const { return RowOffsets[SourceCellIndex + 1] - RowOffsets[SourceCellIndex]; }
+
+	/** Calls Func(int32 CellIndex) for every cell visible from SourceCellIndex, in ascending order. */
+	template<typename FuncType>
+	void ForEachVisibleCell(int32 SourceCellIndex, FuncType&& Func) const
+	{
+		int32 Cursor = 0;
+		const int32 RowEnd = RowOffsets[SourceCellIndex + 1];
+		for (int32 RunIdx = RowOffsets[SourceCellIndex]; RunIdx + 1 < RowEnd; RunIdx += 2)
+		{
+			Cursor += Runs[RunIdx];
+			const int32 SetEnd = Cursor + Runs[RunIdx + 1];
+			for (; Cursor < SetEnd; ++Cursor)
+			{
+				Func(Cursor);
+			}
+		}
+	}
+
+	/** Whether every row is in bounds and decodes to at most GetNumCells() cells. Tables loaded at runtime are checked with this before use. */
+	bool IsConsistent() const;
+
+	SIZE_T GetAllocatedSize() const { return RowOffsets.GetAllocatedSize() + Runs.GetAllocatedSize() + BlockFirstCell.GetAllocatedSize(); }
+
+private:
+	void AddRun(int32 Length);
+
+	UPROPERTY()
+	int32 NumX = 0;
+
+	UPROPERTY()
+	int32 NumY = 0;
+
+	// Start of each row in Runs, plus one past the end of the last row.
+	UPROPERTY()
+	TArray<int32> RowOffsets;
+
+	UPROPERTY()
+	TArray<uint16> Runs;
+
+	// 1 for uniform tables.
+	UPROPERTY()
+	int32 BlockSize = 1;
+
+	// Two-level tables only : index of the first cell of each block, plus one past the last cell. A block holds either 1 or BlockSize^2 cells.
+	UPROPERTY()
+	TArray<int32> BlockFirstCell;
+};
+
+/**
+* Baked Potentially Visible Set of one map, used by UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D.
+* Rows are baked in editor (see Nebula.PVS.Bake) by tracing between sample points of each pair of cells, then cooked with the map.
+* The server loads the asset mapped to the current world in UNebulaReplicationGraphSettings::PVSDataPerMap.
+*/
+UCLASS(BlueprintType)
+class NEBULA_API UNebulaPVSDataAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override { return FPrimaryAssetId(TEXT("NebulaPVSData"), GetFName()); }
+
+	/** Loads the asset mapped to World in UNebulaReplicationGraphSettings::PVSDataPerMap, if any. */
+	static UNebulaPVSDataAsset* FindForWorld(const UWorld* World);
+
+	// Map this table is baked for.
+	UPROPERTY(EditAnywhere, Category = Grid)
+	TSoftObjectPtr<UWorld> Map;
+
+	// Must match the cell size the replication graph runs with. Overrides Nebula.RepGraph.PVSCellSize when loaded.
+	UPROPERTY(EditAnywhere, Category = Grid, meta = (ForceUnits = cm))
+	float CellSize = 200.f;
+
+	// "Min X/Y" of the baked grid. Overrides Nebula.RepGraph.PVSSpatialBiasX/Y when loaded.
+	UPROPERTY(EditAnywhere, Category = Grid, meta = (ForceUnits = cm))
+	FVector2D SpatialBias = FVector2D(-600.f, -600.f);
+
+	// Number of cells on each axis. Cells outside of this have no visibility info.
+	UPROPERTY(EditAnywhere, Category = Grid)
+	FIntPoint GridSize = FIntPoint(7, 7);
+
+	// Above 1, the grid is baked in blocks of BlockSize x BlockSize cells, and blocks with nothing blocking TraceChannel at SampleHeights become one coarse cell.
+	// Only blocks around geometry keep a row per cell, which is what makes open maps with a fine CellSize fit in memory.
+	UPROPERTY(EditAnywhere, Category = Grid, meta = (ClampMin = 1, ClampMax = 64))
+	int32 BlockSize = 1;
+
+	// Sample points inside a cell, normalized to [0, 1]. Two cells are visible to each other if any pair of their sample points is unobstructed.
+	UPROPERTY(EditAnywhere, Category = Bake)
+	TArray<FVector2D> SamplePoints = { FVector2D(0.5f, 0.5f), FVector2D(0.1f, 0.1f), FVector2D(0.9f, 0.1f), FVector2D(0.1f, 0.9f), FVector2D(0.9f, 0.9f) };
+
+	// Heights (world Z) the sample points are traced at. Usually eye heights of the floors of the map.
+	UPROPERTY(EditAnywhere, Category = Bake, meta = (ForceUnits = cm))
+	TArray<float> SampleHeights = { 160.f };
+
+	// Cells further apart than this are never visible to each other. 0 means unlimited, which is O(N^2) traces for N cells.
+	UPROPERTY(EditAnywhere, Category = Bake, meta = (ForceUnits = cm))
+	float MaxVisibleDistance = 0.f;
+
+	UPROPERTY(EditAnywhere, Category = Bake)
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+	// Baked visibility, laid out for GridSize and BlockSize.
+	UPROPERTY()
+	FNebulaPVSTable Table;
+
+	bool IsBaked() const
+	{
+		return GridSize.X > 0 && GridSize.Y > 0 && Table.GetNumX() == GridSize.X && Table.GetNumY() == GridSize.Y
+			&& Table.GetBlockSize() == FMath::Max(BlockSize, 1) && Table.GetNumRows() == Table.GetNumCells();
+	}
+
+#if WITH_EDITOR
+	/**
+	* Traces every pair of cells (within MaxVisibleDistance) in parallel and writes the result to Table. Coarse cells are traced with SamplePoints
+	* spread over the whole block, so they see anything any part of the block sees.
+	* If DirtyRegion is set and the cell layout hasn't changed, only pairs with at least one cell overlapping the region are re-traced.
+	*/
+	void Bake(UWorld* World, const FBox2D* DirtyRegion = nullptr);
+#endif
+};
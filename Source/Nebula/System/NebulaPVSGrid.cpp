@@ -0,0 +1,17 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "NebulaPVSGrid.h"
+
+void FNebulaPVSGrid::GetCells(TConstArrayView<FVector> Locations, TArrayView<FNebulaCellId> OutCells) const
+{
+	Mapping.GetCells(Locations, OutCells);
+
+	if (Table->IsHierarchical())
+	{
+		for (int32 Index = 0; Index < Locations.Num(); ++Index)
+		{
+			OutCells[Index] = ToTableCell(OutCells[Index]);
+		}
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NebulaCellMath.h"
+#include "NebulaPVSData.h"
+
+/**
+* Cell assignment and row lookups over one FNebulaPVSTable, shared by the replication backends.
+* Knows nothing about ReplicationGraph or Iris : UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D buckets actors into GridCells with it,
+* UNebulaPVSNetObjectFilter filters NetObjects with it, so both cull with exactly the same cells, hysteresis and rows.
+*
+* The table is not owned. It must outlive the grid, and Init must be called again whenever its layout changes.
+*/
+struct NEBULA_API FNebulaPVSGrid
+{
+	/** Locations outside of the table bounds map to FNebulaCellId::Overflow(). */
+	void Init(const FNebulaPVSTable& InTable, const FVector2D& InSpatialBias, float InCellSize)
+	{
+		Table = &InTable;
+		CellSize = InCellSize;
+		Mapping.Init(InSpatialBias, InCellSize, FIntPoint(InTable.GetNumX(), InTable.GetNumY()));
+	}
+
+	bool IsInitialized() const { return Table != nullptr; }
+	const FNebulaPVSTable& GetTable() const { check(Table); return *Table; }
+	float GetCellSize() const { return CellSize; }
+
+	/** Cell containing Location. Coarse cells of two-level tables are identified by their origin, so moving inside one never changes the cell. */
+	FNebulaCellId GetCell(const FVector& Location) const
+	{
+		return ToTableCell(Mapping.GetCell(Location));
+	}
+
+	/** Batch version of GetCell. OutCells must be at least as large as Locations. */
+	void GetCells(TConstArrayView<FVector> Locations, TArrayView<FNebulaCellId> OutCells) const;
+
+	/** Canonical cell of a grid coordinate cell. */
+	FNebulaCellId ToTableCell(FNebulaCellId Cell) const
+	{
+		if (!Table->IsHierarchical() || Cell.IsOverflow())
+		{
+			return Cell;
+		}
+
+		const FIntPoint Origin = Table->GetCellOrigin(Cell.GetX(), Cell.GetY());
+		return FNebulaCellId(Origin.X, Origin.Y);
+	}
+
+	/** Whether something at Location is far enough out of Cell to be moved to another one. Unbucketed and overflow cells are always left. */
+	bool HasLeftCell(const FVector& Location, FNebulaCellId Cell, double Hysteresis) const
+	{
+		if (!Cell.IsValid() || Cell.IsOverflow() || Hysteresis <= 0.0)
+		{
+			return true;
+		}
+
+		return !Mapping.IsInsideCell(Location, Cell, Hysteresis, Table->GetCellSpanAt(Cell.GetX(), Cell.GetY()));
+	}
+
+	/** Cell something at Location should be in, given it currently is in CurrentCell. */
+	FNebulaCellId UpdateCell(const FVector& Location, FNebulaCellId CurrentCell, double Hysteresis) const
+	{
+		const FNebulaCellId NewCell = GetCell(Location);
+		return NewCell != CurrentCell && HasLeftCell(Location, CurrentCell, Hysteresis) ? NewCell : CurrentCell;
+	}
+
+	/** Table row of Cell, INDEX_NONE for overflow and unbucketed cells. */
+	int32 GetCellIndex(FNebulaCellId Cell) const
+	{
+		return Cell.IsValid() && !Cell.IsOverflow() ? Table->GetCellIndex(Cell.GetX(), Cell.GetY()) : INDEX_NONE;
+	}
+
+	int32 GetCellIndex(const FVector& Location) const { return GetCellIndex(GetCell(Location)); }
+
+	/** Center of a cell, in grid cells. */
+	FVector2D GetCellCenter(int32 CellIndex) const
+	{
+		return FVector2D(Table->GetCell(CellIndex)) + Table->GetCellSpan(CellIndex) * 0.5;
+	}
+
+	bool IsVisible(int32 ViewerCellIndex, int32 TargetCellIndex) const
+	{
+		return ViewerCellIndex != INDEX_NONE && TargetCellIndex != INDEX_NONE && Table->IsVisible(ViewerCellIndex, TargetCellIndex);
+	}
+
+	template<typename FuncType>
+	void ForEachVisibleCell(int32 ViewerCellIndex, FuncType&& Func) const
+	{
+		Table->ForEachVisibleCell(ViewerCellIndex, Forward<FuncType>(Func));
+	}
+
+private:
+	const FNebulaPVSTable* Table = nullptr;
+	FNebulaCellMapping Mapping;
+	float CellSize = 0.f;
+};
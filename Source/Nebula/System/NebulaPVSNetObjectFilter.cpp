@@ -0,0 +1,249 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "NebulaPVSNetObjectFilter.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "Iris/ReplicationSystem/RepTag.h"
+#include "Iris/ReplicationSystem/ReplicationProtocol.h"
+#include "Iris/ReplicationSystem/ReplicationSystem.h"
+#include "NebulaPVSData.h"
+#include "NebulaReplicationGraph.h"
+
+const FName UNebulaPVSNetObjectFilter::FilterName(TEXT("NebulaPVS"));
+
+namespace Nebula::PVSFilter
+{
+	// Same tag the engine's fragment location grid filter buckets by.
+	static const UE::Net::FRepTag RepTag_WorldLocation = UE::Net::MakeRepTag("WorldLocation");
+}
+
+UNebulaPVSNetObjectFilter* UNebulaPVSNetObjectFilter::FindForWorld(const UWorld* World)
+{
+#if UE_WITH_IRIS
+	UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	UReplicationSystem* ReplicationSystem = NetDriver ? NetDriver->GetReplicationSystem() : nullptr;
+	return ReplicationSystem ? Cast<UNebulaPVSNetObjectFilter>(ReplicationSystem->GetFilter(FilterName)) : nullptr;
+#else
+	return nullptr;
+#endif
+}
+
+void UNebulaPVSNetObjectFilter::SetPVSData(const UNebulaPVSDataAsset* PVSData)
+{
+	PVSTable.Reset();
+	PVSGrid = FNebulaPVSGrid();
+	++TableSerial;
+
+	if (PVSData && PVSData->IsBaked() && PVSData->Table.IsConsistent())
+	{
+		PVSTable = PVSData->Table;
+		PVSGrid.Init(PVSTable, PVSData->SpatialBias, PVSData->CellSize);
+
+		UE_LOG(LogNebulaRepGraph, Display, TEXT("Iris PVS filter loaded %s : %dx%d grid, %d cells, %llu bytes"), *PVSData->GetName(), PVSTable.GetNumX(), PVSTable.GetNumY(), PVSTable.GetNumCells(), (uint64)PVSTable.GetAllocatedSize());
+	}
+	else
+	{
+		UE_LOG(LogNebulaRepGraph, Warning, TEXT("Iris PVS filter has no baked PVS data for this map, objects are not culled. See Nebula.PVS.Bake."));
+	}
+
+	// Cells of the previous table mean nothing in this one.
+	for (TConstSetBitIterator<> It(ObjectsInFilter); It; ++It)
+	{
+		const int32 ObjectIndex = It.GetIndex();
+		ObjectCells[ObjectIndex].Reset();
+		UpdateObjectCell(ObjectIndex, ObjectLocations[ObjectIndex]);
+	}
+}
+
+SIZE_T UNebulaPVSNetObjectFilter::GetAllocatedSize() const
+{
+	SIZE_T Size = PVSTable.GetAllocatedSize() + ObjectsInFilter.GetAllocatedSize() + ObjectCells.GetAllocatedSize() + ObjectCellIndices.GetAllocatedSize()
+		+ ObjectLocations.GetAllocatedSize() + PerConnectionInfos.GetAllocatedSize();
+
+	for (const FPerConnectionInfo& ConnectionInfo : PerConnectionInfos)
+	{
+		Size += ConnectionInfo.ViewerCells.GetAllocatedSize() + ConnectionInfo.VisibleCells.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+void UNebulaPVSNetObjectFilter::OnInit(FNetObjectFilterInitParams& Params)
+{
+	Config = Cast<UNebulaPVSNetObjectFilterConfig>(Params.Config);
+	if (Config == nullptr)
+	{
+		Config = NewObject<UNebulaPVSNetObjectFilterConfig>(this);
+	}
+
+	// Get UpdateObjects calls for objects whose location changed.
+	AddFilterTraits(ENetFilterTraits::Spatial);
+
+	OnMaxInternalNetRefIndexIncreased(Params.CurrentMaxInternalIndex);
+	PerConnectionInfos.SetNum(Params.MaxConnectionCount + 1);
+}
+
+void UNebulaPVSNetObjectFilter::OnDeinit()
+{
+	ObjectsInFilter.Empty();
+	ObjectCells.Empty();
+	ObjectCellIndices.Empty();
+	ObjectLocations.Empty();
+	PerConnectionInfos.Empty();
+}
+
+void UNebulaPVSNetObjectFilter::OnMaxInternalNetRefIndexIncreased(uint32 NewMaxInternalIndex)
+{
+	const int32 NumObjects = (int32)NewMaxInternalIndex;
+	if (NumObjects > ObjectCells.Num())
+	{
+		ObjectsInFilter.SetNum(NumObjects, false);
+		ObjectCells.SetNum(NumObjects);
+		ObjectCellIndices.SetNum(NumObjects);
+		ObjectLocations.SetNumZeroed(NumObjects);
+	}
+}
+
+void UNebulaPVSNetObjectFilter::AddConnection(uint32 ConnectionId)
+{
+	PerConnectionInfos[ConnectionId] = FPerConnectionInfo();
+}
+
+void UNebulaPVSNetObjectFilter::RemoveConnection(uint32 ConnectionId)
+{
+	PerConnectionInfos[ConnectionId] = FPerConnectionInfo();
+}
+
+bool UNebulaPVSNetObjectFilter::AddObject(uint32 ObjectIndex, FNetObjectFilterAddObjectParams& Params)
+{
+	UE::Net::FRepTagFindInfo TagInfo;
+	if (!UE::Net::FindRepTag(Params.Protocol, Nebula::PVSFilter::RepTag_WorldLocation, TagInfo))
+	{
+		UE_LOG(LogNebulaRepGraph, Warning, TEXT("Iris PVS filter can't filter object %u : it doesn't replicate a WorldLocation."), ObjectIndex);
+		return false;
+	}
+
+	if (TagInfo.StateIndex > MAX_uint16 || TagInfo.ExternalStateOffset > MAX_uint16)
+	{
+		return false;
+	}
+
+	FObjectLocationInfo& LocationInfo = static_cast<FObjectLocationInfo&>(Params.OutInfo);
+	LocationInfo.SetStateIndex((uint16)TagInfo.StateIndex);
+	LocationInfo.SetStateOffset((uint16)TagInfo.ExternalStateOffset);
+
+	const uint8* StateBuffer = Params.InstanceProtocol->FragmentData[TagInfo.StateIndex].ExternalSrcBuffer;
+
+	ObjectsInFilter[ObjectIndex] = true;
+	ObjectCells[ObjectIndex].Reset();
+	UpdateObjectCell(ObjectIndex, *reinterpret_cast<const FVector*>(StateBuffer + TagInfo.ExternalStateOffset));
+
+	return true;
+}
+
+void UNebulaPVSNetObjectFilter::RemoveObject(uint32 ObjectIndex, const FNetObjectFilteringInfo& Info)
+{
+	ObjectsInFilter[ObjectIndex] = false;
+	ObjectCells[ObjectIndex].Reset();
+	ObjectCellIndices[ObjectIndex] = INDEX_NONE;
+}
+
+void UNebulaPVSNetObjectFilter::UpdateObjects(FNetObjectFilterUpdateParams& Params)
+{
+	for (uint32 Idx = 0; Idx < Params.ObjectCount; ++Idx)
+	{
+		const uint32 ObjectIndex = Params.ObjectIndices[Idx];
+		const FObjectLocationInfo& LocationInfo = static_cast<const FObjectLocationInfo&>(Params.FilteringInfos[ObjectIndex]);
+
+		const uint8* StateBuffer = Params.InstanceProtocols[Idx]->FragmentData[LocationInfo.GetStateIndex()].ExternalSrcBuffer;
+		UpdateObjectCell(ObjectIndex, *reinterpret_cast<const FVector*>(StateBuffer + LocationInfo.GetStateOffset()));
+	}
+}
+
+void UNebulaPVSNetObjectFilter::UpdateObjectCell(uint32 ObjectIndex, const FVector& Location)
+{
+	ObjectLocations[ObjectIndex] = Location;
+
+	if (!PVSGrid.IsInitialized())
+	{
+		ObjectCellIndices[ObjectIndex] = INDEX_NONE;
+		return;
+	}
+
+	// Same hysteresis as the grid node, so the two backends agree on cells.
+	FNebulaCellId& Cell = ObjectCells[ObjectIndex];
+	Cell = PVSGrid.UpdateCell(Location, Cell, Config->CellHysteresis);
+	ObjectCellIndices[ObjectIndex] = PVSGrid.GetCellIndex(Cell);
+}
+
+void UNebulaPVSNetObjectFilter::UpdateVisibleCells(FPerConnectionInfo& ConnectionInfo, const UE::Net::FReplicationView& View) const
+{
+	bool bChanged = ConnectionInfo.TableSerial != TableSerial || ConnectionInfo.ViewerCells.Num() != View.Views.Num();
+	ConnectionInfo.ViewerCells.SetNum(View.Views.Num());
+
+	for (int32 ViewIdx = 0; ViewIdx < View.Views.Num(); ++ViewIdx)
+	{
+		const FNebulaCellId ViewerCell = PVSGrid.GetCell(View.Views[ViewIdx].Pos);
+		bChanged |= ConnectionInfo.ViewerCells[ViewIdx] != ViewerCell;
+		ConnectionInfo.ViewerCells[ViewIdx] = ViewerCell;
+	}
+
+	if (!bChanged)
+	{
+		return;
+	}
+
+	// Union of the rows of every view, one bit per table cell.
+	ConnectionInfo.TableSerial = TableSerial;
+	ConnectionInfo.bAnyViewerInOverflow = false;
+	ConnectionInfo.VisibleCells.Init(false, PVSGrid.GetTable().GetNumCells());
+
+	for (const FNebulaCellId ViewerCell : ConnectionInfo.ViewerCells)
+	{
+		const int32 ViewerCellIndex = PVSGrid.GetCellIndex(ViewerCell);
+		if (ViewerCellIndex == INDEX_NONE)
+		{
+			ConnectionInfo.bAnyViewerInOverflow = true;
+			continue;
+		}
+
+		PVSGrid.ForEachVisibleCell(ViewerCellIndex, [&ConnectionInfo](int32 CellIndex)
+			{
+				ConnectionInfo.VisibleCells[CellIndex] = true;
+			});
+	}
+}
+
+void UNebulaPVSNetObjectFilter::Filter(FNetObjectFilteringParams& Params)
+{
+	UE::Net::FNetBitArrayView& AllowedObjects = Params.OutAllowedObjects;
+
+	if (!PVSGrid.IsInitialized())
+	{
+		Params.FilteredObjects.ForAllSetBits([&AllowedObjects](uint32 ObjectIndex) { AllowedObjects.SetBit(ObjectIndex); });
+		return;
+	}
+
+	FPerConnectionInfo& ConnectionInfo = PerConnectionInfos[Params.ConnectionId];
+	UpdateVisibleCells(ConnectionInfo, Params.View);
+
+	Params.FilteredObjects.ForAllSetBits([this, &ConnectionInfo, &AllowedObjects](uint32 ObjectIndex)
+		{
+			const int32 CellIndex = ObjectCellIndices[ObjectIndex];
+
+			// Like the grid node's OverflowCell : there's no visibility info out of the table, so only viewers also out there get these.
+			bool bAllowed = ConnectionInfo.bAnyViewerInOverflow;
+			if (CellIndex != INDEX_NONE)
+			{
+				bAllowed = ConnectionInfo.VisibleCells[CellIndex];
+			}
+			else if (!ObjectCells[ObjectIndex].IsOverflow())
+			{
+				// Not bucketed yet.
+				bAllowed = true;
+			}
+
+			AllowedObjects.SetBitValue(ObjectIndex, bAllowed);
+		});
+}
@@ -0,0 +1,112 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Iris/ReplicationSystem/Filtering/NetObjectFilter.h"
+#include "NebulaPVSGrid.h"
+#include "NebulaPVSNetObjectFilter.generated.h"
+
+class UNebulaPVSDataAsset;
+
+UCLASS(transient, config=Engine)
+class UNebulaPVSNetObjectFilterConfig : public UNetObjectFilterConfig
+{
+	GENERATED_BODY()
+
+public:
+	// Objects only move to another cell once they are this far past the boundary of their current one. Same as Nebula.RepGraph.PVSCellHysteresis.
+	UPROPERTY(Config)
+	float CellHysteresis = 50.f;
+};
+
+/**
+* Iris port of UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D : a dynamic filter that allows a connection the objects in the cells its
+* views can see, using the same baked UNebulaPVSDataAsset and FNebulaPVSGrid as the replication graph.
+*
+* Objects are bucketed from their RepTag_WorldLocation state, so only objects replicating a world location can use the filter.
+* Iris calls Filter once per connection, the output is that connection's OutAllowedObjects bits. The row of the connection's viewer cells is decoded
+* into a bitset once and only rebuilt when a viewer changes cell, so the per object cost is one bit test.
+*
+* Setup (DefaultEngine.ini) :
+*	[/Script/IrisCore.NetObjectFilterDefinitions]
+*	+NetObjectFilterDefinitions=(FilterName=NebulaPVS, ClassName=/Script/Nebula.NebulaPVSNetObjectFilter, ConfigClassName=/Script/Nebula.NebulaPVSNetObjectFilterConfig)
+*	[/Script/IrisCore.ObjectReplicationBridgeConfig]
+*	+FilterConfigs=(ClassName=/Script/Nebula.NebulaCharacter, DynamicFilterName=NebulaPVS)
+*
+* The table is loaded by ANebulaGameMode::StartPlay. Until then, or without baked data, everything is allowed.
+* Not ported : audible range, distance tiers, pausing, team vision and multicast culling. Those are ReplicationGraph features with no filter equivalent.
+*/
+UCLASS()
+class UNebulaPVSNetObjectFilter : public UNetObjectFilter
+{
+	GENERATED_BODY()
+
+public:
+	// Name the filter is registered under in NetObjectFilterDefinitions.
+	static const FName FilterName;
+
+	/** The filter of the world's replication system, if Iris is used and the filter is registered. */
+	static UNebulaPVSNetObjectFilter* FindForWorld(const UWorld* World);
+
+	/** Copies the baked table and re-buckets every object. Null or unbaked data disables culling. */
+	void SetPVSData(const UNebulaPVSDataAsset* PVSData);
+
+	const FNebulaPVSGrid& GetPVSGrid() const { return PVSGrid; }
+
+	// Table, per object cells and per connection visible cell bitsets. @see Nebula.RepGraph.MemoryReport
+	SIZE_T GetAllocatedSize() const;
+
+protected:
+	// UNetObjectFilter interface
+	virtual void OnInit(FNetObjectFilterInitParams& Params) override;
+	virtual void OnDeinit() override;
+	virtual void OnMaxInternalNetRefIndexIncreased(uint32 NewMaxInternalIndex) override;
+	virtual void AddConnection(uint32 ConnectionId) override;
+	virtual void RemoveConnection(uint32 ConnectionId) override;
+	virtual bool AddObject(uint32 ObjectIndex, FNetObjectFilterAddObjectParams& Params) override;
+	virtual void RemoveObject(uint32 ObjectIndex, const FNetObjectFilteringInfo& Info) override;
+	virtual void UpdateObjects(FNetObjectFilterUpdateParams& Params) override;
+	virtual void Filter(FNetObjectFilteringParams& Params) override;
+
+private:
+	// Where the object's RepTag_WorldLocation lives, stored in its FNetObjectFilteringInfo.
+	struct FObjectLocationInfo : public FNetObjectFilteringInfo
+	{
+		uint16 GetStateIndex() const { return Data[0]; }
+		void SetStateIndex(uint16 Index) { Data[0] = Index; }
+
+		uint16 GetStateOffset() const { return Data[1]; }
+		void SetStateOffset(uint16 Offset) { Data[1] = Offset; }
+	};
+
+	struct FPerConnectionInfo
+	{
+		// Viewer cells VisibleCells was built for, one per view (split-screen).
+		TArray<FNebulaCellId, TInlineAllocator<2>> ViewerCells;
+		TBitArray<> VisibleCells;
+		bool bAnyViewerInOverflow = false;
+		uint32 TableSerial = 0;
+	};
+
+	void UpdateObjectCell(uint32 ObjectIndex, const FVector& Location);
+	void UpdateVisibleCells(FPerConnectionInfo& ConnectionInfo, const UE::Net::FReplicationView& View) const;
+
+	UPROPERTY()
+	TObjectPtr<UNebulaPVSNetObjectFilterConfig> Config;
+
+	FNebulaPVSTable PVSTable;
+	FNebulaPVSGrid PVSGrid;
+
+	// Bumped by SetPVSData, so connections rebuild their visible cells.
+	uint32 TableSerial = 0;
+
+	// Indexed by internal object index. Locations are kept to re-bucket objects when the table changes.
+	TBitArray<> ObjectsInFilter;
+	TArray<FNebulaCellId> ObjectCells;
+	TArray<int32> ObjectCellIndices;
+	TArray<FVector> ObjectLocations;
+
+	// Indexed by ConnectionId.
+	TArray<FPerConnectionInfo> PerConnectionInfos;
+};
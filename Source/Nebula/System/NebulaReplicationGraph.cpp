@@ -43,6 +43,12 @@
 *		UReplicationGraphNode_TearOff_ForConnection
 *		Connection specific node for handling tear off actors. This is created and managed in the base implementation of Replication Graph.
 *
+*		UNebulaReplicationGraphNode_PVSTeamVision
+*		Shared vision for teams. ORs the PVS rows of all members of a team once per frame, every connection on the team gathers the result instead of its own row.
+*
+*		UNebulaReplicationGraphNode_DedupGatheredLists_ForConnection
+*		Last connection specific node. When Nebula.RepGraph.DedupGatheredLists is on, it merges everything gathered for the connection so each actor appears once.
+*
 *		Added Soon
 *		UNebulaReplicationGraphNode_VisibilityCheck_ForConnection
 * 
@@ -76,6 +82,12 @@
 *
 *		Nebula.RepGraph.PrintRouting - will print the EClassRepNodeMapping for each class. That is, how a given actor class is routed (or not) in the Replication Graph.
 *
+*		Nebula.RepGraph.MemoryReport - prints the memory use of the PVS table, GridCells, actor bookkeeping and per connection caches, with a histogram of actors per cell.
+*
+*		Nebula.RepGraph.ReloadPVS [AssetPath] - swaps in a (re-)baked PVS table on the running server. Actors are only re-bucketed if the cell layout changed.
+*
+*		Nebula.RepGraph.PVSDebugDraw 1 - draws the PVS cells around the local viewer, with the cells visible from the viewer's cell highlighted. Reads the baked asset, so it works on clients.
+*
 */
 
 #include "NebulaReplicationGraph.h"
@@ -95,16 +107,57 @@
 #include "GameFramework/Pawn.h"
 #include "Engine/LevelScriptActor.h"
 #include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/ActorChannel.h"
 #include "UObject/UObjectIterator.h"
+#include "Algo/Accumulate.h"
+#include "Algo/AnyOf.h"
+#include "Algo/Compare.h"
+#include "Algo/Count.h"
+#include "Algo/Sort.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Unique.h"
+#include "Misc/ScopeExit.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
 
 #include "NebulaReplicationGraphSettings.h"
+#include "NebulaPVSData.h"
+#include "NebulaPVSNetObjectFilter.h"
 #include "Nebula/NebulaCharacter.h"
 #include "Nebula/NebulaPlayerController.h"
 #include "Nebula/NebularGameState.h"
 
 DEFINE_LOG_CATEGORY(LogNebulaRepGraph);
 
-#define bUseFastPath 0
+DECLARE_STATS_GROUP(TEXT("NebulaRepGraph"), STATGROUP_NebulaRepGraph, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("PVS PrepareForReplication"), STAT_NebulaRepGraph_PVS_Prepare, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("PVS BuildSharedGatherLists"), STAT_NebulaRepGraph_PVS_BuildSharedLists, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("PVS Gather"), STAT_NebulaRepGraph_PVS_Gather, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("PVS Team Vision"), STAT_NebulaRepGraph_PVS_TeamVision, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("PlayerState PrepareForReplication"), STAT_NebulaRepGraph_PlayerState_Prepare, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("PlayerState Gather"), STAT_NebulaRepGraph_PlayerState_Gather, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("AlwaysRelevantForConnection Gather"), STAT_NebulaRepGraph_AlwaysRelevant_Gather, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("AlwaysRelevantForConnection StreamingLevels"), STAT_NebulaRepGraph_AlwaysRelevant_StreamingLevels, STATGROUP_NebulaRepGraph);
+DECLARE_CYCLE_STAT(TEXT("Dedup Gathered Lists"), STAT_NebulaRepGraph_DedupGatheredLists, STATGROUP_NebulaRepGraph);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("PVS Actors Rebucketed"), STAT_NebulaRepGraph_PVSActorsRebucketed, STATGROUP_NebulaRepGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PVS Cells Gathered"), STAT_NebulaRepGraph_PVSCellsGathered, STATGROUP_NebulaRepGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PVS Row Runs"), STAT_NebulaRepGraph_PVSRowRuns, STATGROUP_NebulaRepGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PVS Lists Emitted"), STAT_NebulaRepGraph_PVSListsEmitted, STATGROUP_NebulaRepGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PVS Tier Reduced Actors"), STAT_NebulaRepGraph_PVSTierReducedActors, STATGROUP_NebulaRepGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PlayerState Lists Emitted"), STAT_NebulaRepGraph_PlayerStateListsEmitted, STATGROUP_NebulaRepGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AlwaysRelevantForConnection Lists Emitted"), STAT_NebulaRepGraph_AlwaysRelevantListsEmitted, STATGROUP_NebulaRepGraph);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gathered Duplicates Removed"), STAT_NebulaRepGraph_GatheredDuplicatesRemoved, STATGROUP_NebulaRepGraph);
+
+CSV_DEFINE_CATEGORY(NebulaRepGraph, true);
+
+// Adds to both the stat counter and the CSV stat of the same name. Counters are summed over all connections of the frame.
+#define NEBULA_REPGRAPH_COUNT(StatName, Value) \
+	INC_DWORD_STAT_BY(STAT_NebulaRepGraph_##StatName, Value); \
+	CSV_CUSTOM_STAT(NebulaRepGraph, StatName, (int32)(Value), ECsvCustomStatOp::Accumulate)
 
 using namespace UE::Net::Private;
 
@@ -142,18 +195,78 @@ namespace Nebula::RepGraph
 	int32 DisableSpatialRebuilds = 1;
 	static FAutoConsoleVariableRef CVarNebulaRepDisableSpatialRebuilds(TEXT("Nebula.RepGraph.DisableSpatialRebuilds"), DisableSpatialRebuilds, TEXT(""), ECVF_Default);
 
+	int32 PVSPreallocateGrid = 1;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSPreallocateGrid(TEXT("Nebula.RepGraph.PVSPreallocateGrid"), PVSPreallocateGrid, TEXT("Use one flat cell array sized from the PVS table bounds instead of growing the grid lazily. Applied when the lookup table is (re)loaded."), ECVF_Default);
+
+	int32 PVSSharedGatherLists = 1;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSSharedGatherLists(TEXT("Nebula.RepGraph.PVSSharedGatherLists"), PVSSharedGatherLists, TEXT("Build one merged gather list per occupied viewer cell in PrepareForReplication and share it across connections. Applied when the lookup table is (re)loaded."), ECVF_Default);
+
+	int32 PVSParallelGather = 1;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSParallelGather(TEXT("Nebula.RepGraph.PVSParallelGather"), PVSParallelGather, TEXT("Build the shared PVS gather lists of all occupied viewer cells across worker threads."), ECVF_Default);
+
+	int32 PVSParallelGatherMinCells = 8;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSParallelGatherMinCells(TEXT("Nebula.RepGraph.PVSParallelGatherMinCells"), PVSParallelGatherMinCells, TEXT("Below this many occupied viewer cells the shared lists are built on the game thread, task overhead would outweigh the gain."), ECVF_Default);
+
+	int32 PVSTeamVision = 1;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSTeamVision(TEXT("Nebula.RepGraph.PVSTeamVision"), PVSTeamVision, TEXT("Players on the same team see everything any teammate's viewer cell can see."), ECVF_Default);
+
+	int32 PVSEventDrivenUpdates = 0;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSEventDrivenUpdates(TEXT("Nebula.RepGraph.PVSEventDrivenUpdates"), PVSEventDrivenUpdates, TEXT("Only re-bucket PVS dynamic actors whose root component reported a move, instead of polling all of them every frame. Applied when the lookup table is (re)loaded."), ECVF_Default);
+
+	int32 PVSMulticastCulling = 1;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSMulticastCulling(TEXT("Nebula.RepGraph.PVSMulticastCulling"), PVSMulticastCulling, TEXT("Only send multicast RPCs of PVS routed actors to connections that can see the caller's cell."), ECVF_Default);
+
+	float PVSAudibleRange = 3000.f;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSAudibleRange(TEXT("Nebula.RepGraph.PVSAudibleRange"), PVSAudibleRange, TEXT("Dynamic PVS actors within this 2D distance but not visible are still gathered at a lower rate and receive multicasts. 0 disables."), ECVF_Default);
+
+	int32 PVSAudibleReplicationPeriod = 4;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSAudibleReplicationPeriod(TEXT("Nebula.RepGraph.PVSAudibleReplicationPeriod"), PVSAudibleReplicationPeriod, TEXT("Audible-only PVS actors are gathered once every this many replication frames."), ECVF_Default);
+
+	float PVSTierMidDistance = 6000.f;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSTierMidDistance(TEXT("Nebula.RepGraph.PVSTierMidDistance"), PVSTierMidDistance, TEXT("Visible PVS actors in cells at least this far from the viewer's cell replicate every PVSTierMidReplicationPeriod frames. 0 disables the distance tiers. Only with PVSSharedGatherLists, for connections whose viewers share one cell and aren't on a team."), ECVF_Default);
+
+	float PVSTierFarDistance = 12000.f;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSTierFarDistance(TEXT("Nebula.RepGraph.PVSTierFarDistance"), PVSTierFarDistance, TEXT("Visible PVS actors in cells at least this far from the viewer's cell replicate every PVSTierFarReplicationPeriod frames. 0 disables the far tier. Only with PVSSharedGatherLists."), ECVF_Default);
+
+	int32 PVSTierMidReplicationPeriod = 2;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSTierMidReplicationPeriod(TEXT("Nebula.RepGraph.PVSTierMidReplicationPeriod"), PVSTierMidReplicationPeriod, TEXT("Minimum ReplicationPeriodFrame of visible PVS actors in the mid distance tier. Only with PVSSharedGatherLists."), ECVF_Default);
+
+	int32 PVSTierFarReplicationPeriod = 4;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSTierFarReplicationPeriod(TEXT("Nebula.RepGraph.PVSTierFarReplicationPeriod"), PVSTierFarReplicationPeriod, TEXT("Minimum ReplicationPeriodFrame of visible PVS actors in the far distance tier. Only with PVSSharedGatherLists."), ECVF_Default);
+
+	int32 PVSPauseFrames = 60;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSPauseFrames(TEXT("Nebula.RepGraph.PVSPauseFrames"), PVSPauseFrames, TEXT("Frames a channel is kept open without replicating after a dynamic PVS actor leaves the viewer's visible cells. 0 disables."), ECVF_Default);
+
+	float PVSCellHysteresis = 50.f;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSCellHysteresis(TEXT("Nebula.RepGraph.PVSCellHysteresis"), PVSCellHysteresis, TEXT("Distance past a cell boundary a dynamic PVS actor has to move before it is re-bucketed."), ECVF_Default);
+
+	int32 PVSLogCellChanges = 0;
+	static FAutoConsoleVariableRef CVarNebulaRepPVSLogCellChanges(TEXT("Nebula.RepGraph.PVSLogCellChanges"), PVSLogCellChanges, TEXT("Log every cell change of dynamic PVS actors, and at Verbose every add and remove."), ECVF_Default);
+
+	int32 DedupGatheredLists = 0;
+	static FAutoConsoleVariableRef CVarNebulaRepDedupGatheredLists(TEXT("Nebula.RepGraph.DedupGatheredLists"), DedupGatheredLists, TEXT("Merge the lists gathered for each connection so every actor is prioritized at most once per frame."), ECVF_Default);
+
+	float PlayerStateKBytesSec = 8.f;
+	static FAutoConsoleVariableRef CVarNebulaRepPlayerStateKBytesSec(TEXT("Nebula.RepGraph.PlayerState.KBytesSec"), PlayerStateKBytesSec, TEXT("Per connection bandwidth budget for PlayerState updates. Drives the PlayerState limiter's actors per frame and the owner's PlayerState throttle."), ECVF_Default);
+
+	int32 PlayerStateEstimatedBytes = 64;
+	static FAutoConsoleVariableRef CVarNebulaRepPlayerStateEstimatedBytes(TEXT("Nebula.RepGraph.PlayerState.EstimatedBytes"), PlayerStateEstimatedBytes, TEXT("Average size of one PlayerState update."), ECVF_Default);
+
+	float PlayerStateFullCycleSeconds = 0.5f;
+	static FAutoConsoleVariableRef CVarNebulaRepPlayerStateFullCycleSeconds(TEXT("Nebula.RepGraph.PlayerState.FullCycleSeconds"), PlayerStateFullCycleSeconds, TEXT("Desired time for a full pass over every PlayerState, while it fits the budget."), ECVF_Default);
+
 	int32 LogLazyInitClasses = 0;
 	static FAutoConsoleVariableRef CVarNebulaRepLogLazyInitClasses(TEXT("Nebula.RepGraph.LogLazyInitClasses"), LogLazyInitClasses, TEXT(""), ECVF_Default);
 
 	// How much bandwidth to use for FastShared movement updates. This is counted independently of the NetDriver's target bandwidth.
 	int32 TargetKBytesSecFastSharedPath = 10;
-	static FAutoConsoleVariableRef CVarNebulaRepTargetKBytesSecFastSharedPath(TEXT("Nebula.RepGraph.TargetKBytesSecFastSharedPath"), TargetKBytesSecFastSharedPath, TEXT(""), ECVF_Default);
+	static FAutoConsoleVariableRef CVarNebulaRepTargetKBytesSecFastSharedPath(TEXT("Nebula.RepGraph.TargetKBytesSecFastSharedPath"), TargetKBytesSecFastSharedPath, TEXT("Per connection bandwidth of FastShared movement updates, on top of the NetDriver's."), ECVF_Default);
 
 	float FastSharedPathCullDistPct = 0.80f;
-	static FAutoConsoleVariableRef CVarNebulaRepFastSharedPathCullDistPct(TEXT("Nebula.RepGraph.FastSharedPathCullDistPct"), FastSharedPathCullDistPct, TEXT(""), ECVF_Default);
+	static FAutoConsoleVariableRef CVarNebulaRepFastSharedPathCullDistPct(TEXT("Nebula.RepGraph.FastSharedPathCullDistPct"), FastSharedPathCullDistPct, TEXT("FastShared updates are only sent within this fraction of the actor's cull distance."), ECVF_Default);
 
 	int32 EnableFastSharedPath = 1;
-	static FAutoConsoleVariableRef CVarNebulaRepEnableFastSharedPath(TEXT("Nebula.RepGraph.EnableFastSharedPath"), EnableFastSharedPath, TEXT(""), ECVF_Default);
+	static FAutoConsoleVariableRef CVarNebulaRepEnableFastSharedPath(TEXT("Nebula.RepGraph.EnableFastSharedPath"), EnableFastSharedPath, TEXT("Send character movement between full updates through one shared bunch per character per frame."), ECVF_Default);
 
 	UReplicationDriver* ConditionalCreateReplicationDriver(UNetDriver* ForNetDriver, UWorld* World)
 	{
@@ -269,6 +382,20 @@ void UNebulaReplicationGraph::ResetGameWorldState()
 	}
 }
 
+void UNebulaReplicationGraph::InitializeForWorld(UWorld* World)
+{
+	// The world may not be set yet when InitGlobalGraphNodes runs, and can change on travel. Load the baked PVS of the new map
+	// before Super routes the world's actors, so they are bucketed with the table they will be gathered with.
+	// Drop the previous world's actors first : Super resets them too, but only after the table is loaded, which would re-bucket them.
+	if (PVSGridNode && World)
+	{
+		PVSGridNode->NotifyResetAllNetworkActors();
+		PVSGridNode->InitLookupTable(UNebulaPVSDataAsset::FindForWorld(World));
+	}
+
+	Super::InitializeForWorld(World);
+}
+
 EClassRepNodeMapping UNebulaReplicationGraph::GetClassNodeMapping(UClass* Class) const
 {
 	if (!Class)
@@ -491,9 +618,6 @@ void UNebulaReplicationGraph::InitGlobalActorClassSettings()
 	CharacterClassRepInfo.ActorChannelFrameTimeout = 4;
 	CharacterClassRepInfo.SetCullDistanceSquared(ANebulaCharacter::StaticClass()->GetDefaultObject<ANebulaCharacter>()->GetNetCullDistanceSquared());
 
-	SetClassInfo(ANebulaCharacter::StaticClass(), CharacterClassRepInfo);
-
-#if bUseFastPath
 	{
 		// Sanity check our FSharedRepMovement type has the same quantization settings as the default character.
 		FRepMovement DefaultRepMovement = ANebulaCharacter::StaticClass()->GetDefaultObject<ANebulaCharacter>()->GetReplicatedMovement(); // Use the same quantization settings as our default replicatedmovement
@@ -522,16 +646,17 @@ void UNebulaReplicationGraph::InitGlobalActorClassSettings()
 
 	FastSharedPathConstants.MaxBitsPerFrame = (int32)((float)(Nebula::RepGraph::TargetKBytesSecFastSharedPath * 1024 * 8) / NetDriver->GetNetServerMaxTickRate());
 	FastSharedPathConstants.DistanceRequirementPct = Nebula::RepGraph::FastSharedPathCullDistPct;
-#endif
+
 	SetClassInfo(ANebulaCharacter::StaticClass(), CharacterClassRepInfo);
 
 	// ---------------------------------------------------------------------
 	UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.ListSize = 12;
 	UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.NumBuckets = Nebula::RepGraph::DynamicActorFrequencyBuckets;
 	UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.BucketThresholds.Reset();
-	// FastPath off now
-	//UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.EnableFastPath = (Nebula::RepGraph::EnableFastSharedPath > 0);
-	//UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.FastPathFrameModulo = 1;
+	// Actors outside of the current bucket are returned as FastShared lists, that is how GridCells feed the FastShared path.
+	// Shared PVS gather lists bucket the same way, see UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::BuildSharedGatherLists.
+	UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.EnableFastPath = (Nebula::RepGraph::EnableFastSharedPath > 0);
+	UReplicationGraphNode_ActorListFrequencyBuckets::DefaultSettings.FastPathFrameModulo = 1;
 
 	RPCSendPolicyMap.Reset();
 
@@ -592,6 +717,12 @@ void UNebulaReplicationGraph::InitGlobalActorClassSettings()
 			}
 		}
 	}
+
+	PVSMulticastCullingExemptFunctions.Reset();
+	PVSMulticastCullingExemptFunctions.Append(NebulaRepGraphSettings->PVSMulticastCullingExemptFunctions);
+
+	// The FastShared RPC is captured into the shared bunch by UReplicationGraph::ProcessRemoteFunction, it must reach Super. Who receives it is decided by the gathered FastShared lists.
+	PVSMulticastCullingExemptFunctions.Add(CharacterClassRepInfo.FastSharedReplicationFuncName);
 }
 
 void UNebulaReplicationGraph::InitGlobalGraphNodes()
@@ -619,7 +750,7 @@ void UNebulaReplicationGraph::InitGlobalGraphNodes()
 	// -----------------------------------------------
 	//	Player State specialization. This will return a rolling subset of the player states to replicate
 	// -----------------------------------------------
-	UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter* PlayerStateNode = CreateNewNode<UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter>();
+	PlayerStateNode = CreateNewNode<UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter>();
 	AddGlobalGraphNode(PlayerStateNode);
 
 	// -----------------------------------------------
@@ -631,11 +762,14 @@ void UNebulaReplicationGraph::InitGlobalGraphNodes()
 	PVSGridNode->CellSize = RepGraphSettings->PVSSCellSize;
 	PVSGridNode->SpatialBias = FVector2D(RepGraphSettings->PVSSpatialBiasX, RepGraphSettings->PVSSpatialBiasY);
 
-	PVSGridNode->GenerateLookupTable();
+	PVSGridNode->InitLookupTable(UNebulaPVSDataAsset::FindForWorld(GetWorld()));
 
 	AddGlobalGraphNode(PVSGridNode);
 
-	UE_LOG(LogNebulaRepGraph, Warning, TEXT("UReplicationGraphNode_GridCell's size : %d bytes"), sizeof(UReplicationGraphNode_GridCell));
+	// Prepared after PVSGridNode, it uses the cells that node has just updated.
+	PVSTeamNode = CreateNewNode<UNebulaReplicationGraphNode_PVSTeamVision>();
+	PVSTeamNode->PVSNode = PVSGridNode;
+	AddGlobalGraphNode(PVSTeamNode);
 }
 
 void UNebulaReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
@@ -649,6 +783,142 @@ void UNebulaReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConne
 	RepGraphConnection->OnClientVisibleLevelNameRemove.AddUObject(AlwaysRelevantConnectionNode, &UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove);
 
 	AddConnectionGraphNode(AlwaysRelevantConnectionNode, RepGraphConnection);
+
+	// Must stay the last connection node, it rewrites what every node before it gathered.
+	AddConnectionGraphNode(CreateNewNode<UNebulaReplicationGraphNode_DedupGatheredLists_ForConnection>(), RepGraphConnection);
+}
+
+bool UNebulaReplicationGraph::ProcessRemoteFunction(class AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, class UObject* SubObject)
+{
+	if (Nebula::RepGraph::PVSMulticastCulling > 0 && PVSGridNode && Actor && Function && EnumHasAnyFlags(Function->FunctionFlags, FUNC_NetMulticast)
+		&& IsPrecomputedVisibility(GetMappingPolicy(Actor->GetClass())))
+	{
+		// Overrides are cached and exempted under the topmost declaration, same as Super does.
+		UFunction* TopFunction = Function;
+		while (UFunction* SuperFunction = TopFunction->GetSuperFunction())
+		{
+			TopFunction = SuperFunction;
+		}
+
+		if (!PVSMulticastCullingExemptFunctions.Contains(TopFunction->GetFName()) && ProcessMulticast_PrecomputedVisibility(Actor, TopFunction, Parameters, OutParms, Stack, SubObject))
+		{
+			return true;
+		}
+	}
+
+	return Super::ProcessRemoteFunction(Actor, Function, Parameters, OutParms, Stack, SubObject);
+}
+
+bool UNebulaReplicationGraph::ProcessMulticast_PrecomputedVisibility(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject)
+{
+	// Super reports and drops these.
+	if (!IsActorValidForReplication(Actor) || Actor->IsActorBeingDestroyed())
+	{
+		return false;
+	}
+
+	FGlobalActorReplicationInfo& GlobalInfo = GlobalActorReplicationInfoMap.Get(Actor);
+	const int32 ActorCellIndex = PVSGridNode->GetTableCellIndex(GlobalInfo.WorldLocation);
+	if (ActorCellIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	UObject* TargetObj = SubObject ? SubObject : Actor;
+	FClassNetCache* ClassCache = NetDriver->NetCache->GetClassNetCache(TargetObj->GetClass());
+	const FFieldNetCache* FieldCache = ClassCache ? ClassCache->GetFromField(Function) : nullptr;
+	if (FieldCache == nullptr)
+	{
+		return false;
+	}
+
+	ERemoteFunctionSendPolicy SendPolicy = ERemoteFunctionSendPolicy::Default;
+	if (CVar_RepGraph_EnableRPCSendPolicy > 0)
+	{
+		if (FRPCSendPolicyInfo* FuncSendPolicy = RPCSendPolicyMap.Find(FObjectKey(Function)))
+		{
+			if (FuncSendPolicy->bSendImmediately)
+			{
+				SendPolicy = ERemoteFunctionSendPolicy::ForceSend;
+			}
+		}
+	}
+
+	const bool* OpenChannelForClass = RPC_Multicast_OpenChannelForClass.Get(Actor->GetClass());
+	const bool bOpenChannel = OpenChannelForClass == nullptr || *OpenChannelForClass;
+	bool bForceFlushNetDormancy = false;
+
+	const UNetConnection* OwningConnection = Actor->GetNetConnection();
+	for (UNetReplicationGraphConnection* ConnectionManager : Connections)
+	{
+		UNetConnection* NetConnection = ConnectionManager->NetConnection;
+
+		// Visibility is symmetric, so the viewer's row holding the caller's cell is enough. Viewers out of the table see nothing.
+		// Viewers in earshot get it too : sound events are most of the multicasts worth sending to someone behind a wall.
+		if (NetConnection != OwningConnection && PVSTeamNode && PVSTeamNode->IsTeamConnection(NetConnection))
+		{
+			// Follow the team's vision. Earshot is still the member's own : the PVS node gathers audible actors for team connections too.
+			if (!PVSTeamNode->IsCellVisibleToTeam(NetConnection, ActorCellIndex))
+			{
+				FNebulaCellId ViewerCell;
+				FVector ViewerLocation;
+				if (!PVSGridNode->GetViewerCell(NetConnection, ViewerCell, &ViewerLocation) || ViewerCell.IsOverflow() || !PVSGridNode->IsAudible(ViewerLocation, GlobalInfo.WorldLocation))
+				{
+					continue;
+				}
+			}
+		}
+		else if (NetConnection != OwningConnection)
+		{
+			FNebulaCellId ViewerCell;
+			FVector ViewerLocation;
+			if (!PVSGridNode->GetViewerCell(NetConnection, ViewerCell, &ViewerLocation) || ViewerCell.IsOverflow())
+			{
+				continue;
+			}
+
+			const int32 ViewerCellIndex = PVSGridNode->GetPVSTable().GetCellIndex(ViewerCell.GetX(), ViewerCell.GetY());
+			if (!PVSGridNode->GetPVSTable().IsVisible(ViewerCellIndex, ActorCellIndex) && !PVSGridNode->IsAudible(ViewerLocation, GlobalInfo.WorldLocation))
+			{
+				continue;
+			}
+		}
+
+		FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionManager->ActorInfoMap.FindOrAdd(Actor);
+
+		// Dormant channels are closed. Flushing brings the actor back on the connections that can see it, like Super does.
+		if (ConnectionActorInfo.bDormantOnConnection)
+		{
+			bForceFlushNetDormancy = true;
+			continue;
+		}
+
+		// The PVS stands in for Super's cull distance test : the caller is visible to this connection, so open a channel if its class allows it.
+		UActorChannel* ActorChannel = ConnectionActorInfo.Channel;
+		if (ActorChannel == nullptr && bOpenChannel && NetConnection->IsReplicationEnabled())
+		{
+			ActorChannel = Cast<UActorChannel>(NetConnection->CreateChannelByName(NAME_Actor, EChannelCreateFlags::OpenedLocally));
+			if (ActorChannel)
+			{
+				ActorChannel->SetChannelActor(Actor, ESetChannelActorFlags::None);
+				ConnectionActorInfo.Channel = ActorChannel;
+			}
+		}
+
+		if (ActorChannel == nullptr || ActorChannel->Closing)
+		{
+			continue;
+		}
+
+		NetDriver->ProcessRemoteFunctionForChannel(ActorChannel, ClassCache, FieldCache, TargetObj, NetConnection, Function, Parameters, OutParms, Stack, true, SendPolicy);
+	}
+
+	if (bForceFlushNetDormancy)
+	{
+		Actor->FlushNetDormancy();
+	}
+
+	return true;
 }
 
 EClassRepNodeMapping UNebulaReplicationGraph::GetMappingPolicy(UClass* Class)
@@ -665,17 +935,31 @@ void UNebulaReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedAc
 	{
 	case EClassRepNodeMapping::NotRouted:
 	{
+		// Simulated proxy player states are handed out by the frequency limiter.
+		if (ActorInfo.Actor->IsA<APlayerState>())
+		{
+			PlayerStateNode->NotifyAddNetworkActor(ActorInfo);
+		}
 		break;
 	}
 
-	// now only support dynamic, $todo : add case of static, dormancy
 	case EClassRepNodeMapping::PrecomputedVisibility:
 	{
 		PVSGridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
 		break;
 	}
-	// $TODO : precompueted visibility - static
-	// $TODO : precomputed visibility - dormancy
+
+	case EClassRepNodeMapping::PrecomputedVisibility_Static:
+	{
+		PVSGridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	}
+
+	case EClassRepNodeMapping::PrecomputedVisibility_Dormancy:
+	{
+		PVSGridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	}
 
 	case EClassRepNodeMapping::RelevantAllConnections:
 	{
@@ -685,8 +969,19 @@ void UNebulaReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedAc
 		}
 		else
 		{
-			FActorRepListRefView& RepList = AlwaysRelevantStreamingLevelActors.FindOrAdd(ActorInfo.StreamingLevelName);
-			RepList.ConditionalAdd(ActorInfo.Actor);
+			FNebulaAlwaysRelevantStreamingLevel& Level = AlwaysRelevantStreamingLevelActors.FindOrAdd(ActorInfo.StreamingLevelName);
+			if (!Level.Actors.Contains(ActorInfo.Actor))
+			{
+				Level.Actors.Add(ActorInfo.Actor);
+				if (!GlobalInfo.bWantsToBeDormant)
+				{
+					++Level.NumNonDormant;
+				}
+				WakeStreamingLevel(Level);
+
+				GlobalInfo.Events.DormancyChange.AddUObject(this, &UNebulaReplicationGraph::OnStreamingLevelActorDormancyChange);
+				GlobalInfo.Events.DormancyFlush.AddUObject(this, &UNebulaReplicationGraph::OnStreamingLevelActorDormancyFlush);
+			}
 		}
 		break;
 	}
@@ -718,19 +1013,30 @@ void UNebulaReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicate
 	{
 	case EClassRepNodeMapping::NotRouted:
 	{
+		if (ActorInfo.Actor->IsA<APlayerState>())
+		{
+			PlayerStateNode->NotifyRemoveNetworkActor(ActorInfo);
+		}
 		break;
 	}
 
 	case EClassRepNodeMapping::PrecomputedVisibility:
 	{
-		// now only support dynamic, $todo : add case of static, dormancy
 		PVSGridNode->RemoveActor_Dynamic(ActorInfo);
 		break;
 	}
 
-	// $TODO : precompueted visibility - static
+	case EClassRepNodeMapping::PrecomputedVisibility_Static:
+	{
+		PVSGridNode->RemoveActor_Static(ActorInfo);
+		break;
+	}
 
-	// $TODO : precomputed visibility - dormancy
+	case EClassRepNodeMapping::PrecomputedVisibility_Dormancy:
+	{
+		PVSGridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	}
 
 	case EClassRepNodeMapping::RelevantAllConnections:
 	{
@@ -740,11 +1046,21 @@ void UNebulaReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicate
 		}
 		else
 		{
-			FActorRepListRefView& RepList = AlwaysRelevantStreamingLevelActors.FindChecked(ActorInfo.StreamingLevelName);
-			if (RepList.RemoveFast(ActorInfo.Actor) == false)
+			FNebulaAlwaysRelevantStreamingLevel& Level = AlwaysRelevantStreamingLevelActors.FindChecked(ActorInfo.StreamingLevelName);
+			if (Level.Actors.RemoveFast(ActorInfo.Actor) == false)
 			{
 				UE_LOG(LogNebulaRepGraph, Warning, TEXT("Actor %s was not found in AlwaysRelevantStreamingLevelActors list. LevelName: %s"), *GetActorRepListTypeDebugString(ActorInfo.Actor), *ActorInfo.StreamingLevelName.ToString());
 			}
+			else if (FGlobalActorReplicationInfo* GlobalInfo = GlobalActorReplicationInfoMap.Find(ActorInfo.Actor))
+			{
+				if (!GlobalInfo->bWantsToBeDormant)
+				{
+					Level.NumNonDormant = FMath::Max(Level.NumNonDormant - 1, 0);
+				}
+
+				GlobalInfo->Events.DormancyChange.RemoveAll(this);
+				GlobalInfo->Events.DormancyFlush.RemoveAll(this);
+			}
 		}
 
 		SetActorDestructionInfoToIgnoreDistanceCulling(ActorInfo.GetActor());
@@ -783,16 +1099,75 @@ void UNebulaReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicate
 
 // Swap Weapon - @see ShooterReplicationGraph
 
+void UNebulaReplicationGraph::OnStreamingLevelActorDormancyChange(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo, ENetDormancy NewValue, ENetDormancy OldValue)
+{
+	const bool bDormant = NewValue > DORM_Awake;
+	if (bDormant == (OldValue > DORM_Awake))
+	{
+		return;
+	}
+
+	FNebulaAlwaysRelevantStreamingLevel* Level = AlwaysRelevantStreamingLevelActors.Find(FNewReplicatedActorInfo(Actor).StreamingLevelName);
+	if (Level == nullptr)
+	{
+		return;
+	}
+
+	if (bDormant)
+	{
+		Level->NumNonDormant = FMath::Max(Level->NumNonDormant - 1, 0);
+	}
+	else if (Level->NumNonDormant++ == 0)
+	{
+		// Connections only stop gathering a level once nothing on it is awake, so this is the only transition they need to hear about.
+		WakeStreamingLevel(*Level);
+	}
+}
+
+void UNebulaReplicationGraph::OnStreamingLevelActorDormancyFlush(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	// Still dormant, but has to replicate once more to every connection.
+	if (FNebulaAlwaysRelevantStreamingLevel* Level = AlwaysRelevantStreamingLevelActors.Find(FNewReplicatedActorInfo(Actor).StreamingLevelName))
+	{
+		WakeStreamingLevel(*Level);
+	}
+}
+
+void UNebulaReplicationGraph::WakeStreamingLevel(FNebulaAlwaysRelevantStreamingLevel& Level)
+{
+	++Level.WakeSerial;
+	++AlwaysRelevantStreamingLevelWakeSerial;
+}
+
 // ------------------------------------------------------------------------------
 
+uint32 UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::GetOwnerPlayerStateReplicationPeriod() const
+{
+	const UNebulaReplicationGraph* NebulaGraph = Cast<UNebulaReplicationGraph>(GraphGlobals->ReplicationGraph);
+	return (NebulaGraph && NebulaGraph->PlayerStateNode) ? FMath::Max(NebulaGraph->PlayerStateNode->GetOwnerPlayerStateReplicationPeriod(), 1u) : 2u;
+}
+
 void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::ResetGameWorldState()
 {
 	ReplicationActorList.Reset();
 	AlwaysRelevantStreamingLevelsNeedingReplication.Empty();
+	DormantStreamingLevels.Empty();
+	LastStreamingLevelWakeSerial = 0;
+}
+
+SIZE_T UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::GetAllocatedSize() const
+{
+	return PastRelevantActorMap.GetAllocatedSize() + AlwaysRelevantStreamingLevelsNeedingReplication.GetAllocatedSize() + DormantStreamingLevels.GetAllocatedSize()
+		+ ReplicationActorList.Num() * sizeof(FActorRepListType);
 }
 
 void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
 {
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_AlwaysRelevant_Gather);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, AlwaysRelevant_Gather);
+
+	const int32 NumListsBefore = Params.OutGatheredReplicationLists.NumLists();
+
 	UNebulaReplicationGraph* NebulaGraph = CastChecked<UNebulaReplicationGraph>(GetOuter());
 
 	ReplicationActorList.Reset();
@@ -804,8 +1179,9 @@ void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsF
 
 		if (ANebulaPlayerController* PC = Cast<ANebulaPlayerController>(CurViewer.InViewer))
 		{
-			// 50% throttling of PlayerStates.
-			const bool bReplicatePS = (Params.ConnectionManager.ConnectionOrderNum % 2) == (Params.ReplicationFrameNum % 2);
+			// Throttling of PlayerStates, driven by Nebula.RepGraph.PlayerState.KBytesSec. Connections are staggered by their order.
+			const uint32 PSPeriod = GetOwnerPlayerStateReplicationPeriod();
+			const bool bReplicatePS = (Params.ConnectionManager.ConnectionOrderNum % PSPeriod) == (Params.ReplicationFrameNum % PSPeriod);
 			if (bReplicatePS)
 			{
 				// Always return the player state to the owning player. Simulated proxy player states are handled by UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter
@@ -846,67 +1222,89 @@ void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsF
 	// Always relevant streaming level actors.
 	FPerConnectionActorInfoMap& ConnectionActorInfoMap = Params.ConnectionManager.ActorInfoMap;
 
-	TMap<FName, FActorRepListRefView>& AlwaysRelevantStreamingLevelActors = NebulaGraph->AlwaysRelevantStreamingLevelActors;
+	TMap<FName, FNebulaAlwaysRelevantStreamingLevel>& AlwaysRelevantStreamingLevelActors = NebulaGraph->AlwaysRelevantStreamingLevelActors;
 
-	for (int32 Idx = AlwaysRelevantStreamingLevelsNeedingReplication.Num() - 1; Idx >= 0; --Idx)
 	{
-		const FName& StreamingLevel = AlwaysRelevantStreamingLevelsNeedingReplication[Idx];
+		SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_AlwaysRelevant_StreamingLevels);
+		CSV_SCOPED_TIMING_STAT(NebulaRepGraph, AlwaysRelevant_StreamingLevels);
 
-		FActorRepListRefView* Ptr = AlwaysRelevantStreamingLevelActors.Find(StreamingLevel);
-		if (Ptr == nullptr)
+		// Pick back up the levels that had an actor added, woken up or flushed since they went dormant for this connection.
+		if (LastStreamingLevelWakeSerial != NebulaGraph->AlwaysRelevantStreamingLevelWakeSerial)
 		{
-			// No always relevant lists for that level
-			UE_CLOG(Nebula::RepGraph::DisplayClientLevelStreaming > 0, LogNebulaRepGraph, Display, TEXT("CLIENTSTREAMING Removing %s from AlwaysRelevantStreamingLevelActors because FActorRepListRefView is null. %s "), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
-			AlwaysRelevantStreamingLevelsNeedingReplication.RemoveAtSwap(Idx, EAllowShrinking::No);
-			continue;
+			LastStreamingLevelWakeSerial = NebulaGraph->AlwaysRelevantStreamingLevelWakeSerial;
+			for (auto It = DormantStreamingLevels.CreateIterator(); It; ++It)
+			{
+				const FNebulaAlwaysRelevantStreamingLevel* Level = AlwaysRelevantStreamingLevelActors.Find(It.Key());
+				if (Level && Level->WakeSerial != It.Value())
+				{
+					UE_CLOG(Nebula::RepGraph::DisplayClientLevelStreaming > 0, LogNebulaRepGraph, Display, TEXT("CLIENTSTREAMING Waking StreamingLevel %s for %s"), *It.Key().ToString(), *Params.ConnectionManager.GetName());
+					AlwaysRelevantStreamingLevelsNeedingReplication.Add(It.Key());
+					It.RemoveCurrent();
+				}
+			}
 		}
 
-		FActorRepListRefView& RepList = *Ptr;
-
-		if (RepList.Num() > 0)
+		for (int32 Idx = AlwaysRelevantStreamingLevelsNeedingReplication.Num() - 1; Idx >= 0; --Idx)
 		{
-			bool bAllDormant = true;
-			for (FActorRepListType Actor : RepList)
+			const FName StreamingLevel = AlwaysRelevantStreamingLevelsNeedingReplication[Idx];
+
+			FNebulaAlwaysRelevantStreamingLevel* Level = AlwaysRelevantStreamingLevelActors.Find(StreamingLevel);
+			if (Level == nullptr)
+			{
+				// No always relevant lists for that level (yet). Adding one wakes it.
+				UE_CLOG(Nebula::RepGraph::DisplayClientLevelStreaming > 0, LogNebulaRepGraph, Display, TEXT("CLIENTSTREAMING Removing %s from AlwaysRelevantStreamingLevelActors because FActorRepListRefView is null. %s "), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
+				DormantStreamingLevels.Add(StreamingLevel, 0);
+				AlwaysRelevantStreamingLevelsNeedingReplication.RemoveAtSwap(Idx, EAllowShrinking::No);
+				continue;
+			}
+
+			// Something is awake : no need to look at the actors, the driver skips whatever is dormant on this connection itself.
+			bool bAllDormant = Level->NumNonDormant == 0;
+
+			// Everything wants to be dormant. Keep gathering until it actually is on this connection, so the last state gets sent before the channels go dormant.
+			if (bAllDormant)
 			{
-				FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
-				if (ConnectionActorInfo.bDormantOnConnection == false)
+				for (FActorRepListType Actor : Level->Actors)
 				{
-					bAllDormant = false;
-					break;
+					FConnectionReplicationActorInfo& ConnectionActorInfo = ConnectionActorInfoMap.FindOrAdd(Actor);
+					if (ConnectionActorInfo.bDormantOnConnection == false)
+					{
+						bAllDormant = false;
+						break;
+					}
 				}
 			}
 
 			if (bAllDormant)
 			{
 				UE_CLOG(Nebula::RepGraph::DisplayClientLevelStreaming > 0, LogNebulaRepGraph, Display, TEXT("CLIENTSTREAMING All AlwaysRelevant Actors Dormant on StreamingLevel %s for %s. Removing list."), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
+				DormantStreamingLevels.Add(StreamingLevel, Level->WakeSerial);
 				AlwaysRelevantStreamingLevelsNeedingReplication.RemoveAtSwap(Idx, EAllowShrinking::No);
 			}
 			else
 			{
 				UE_CLOG(Nebula::RepGraph::DisplayClientLevelStreaming > 0, LogNebulaRepGraph, Display, TEXT("CLIENTSTREAMING Adding always Actors on StreamingLevel %s for %s because it has at least one non dormant actor"), *StreamingLevel.ToString(), *Params.ConnectionManager.GetName());
-				Params.OutGatheredReplicationLists.AddReplicationActorList(RepList);
+				Params.OutGatheredReplicationLists.AddReplicationActorList(Level->Actors);
 			}
 		}
-		else
-		{
-			UE_LOG(LogNebulaRepGraph, Warning, TEXT("UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection - empty RepList %s"), *Params.ConnectionManager.GetName());
-		}
-
 	}
 
 	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+	NEBULA_REPGRAPH_COUNT(AlwaysRelevantListsEmitted, Params.OutGatheredReplicationLists.NumLists() - NumListsBefore);
 }
 
 void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityAdd(FName LevelName, UWorld* StreamingWorld)
 {
 	UE_CLOG(Nebula::RepGraph::DisplayClientLevelStreaming > 0, LogNebulaRepGraph, Display, TEXT("CLIENTSTREAMING ::OnClientLevelVisibilityAdd - %s"), *LevelName.ToString());
-	AlwaysRelevantStreamingLevelsNeedingReplication.Add(LevelName);
+	DormantStreamingLevels.Remove(LevelName);
+	AlwaysRelevantStreamingLevelsNeedingReplication.AddUnique(LevelName);
 }
 
 void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::OnClientLevelVisibilityRemove(FName LevelName)
 {
 	UE_CLOG(Nebula::RepGraph::DisplayClientLevelStreaming > 0, LogNebulaRepGraph, Display, TEXT("CLIENTSTREAMING ::OnClientLevelVisibilityRemove - %s"), *LevelName.ToString());
 	AlwaysRelevantStreamingLevelsNeedingReplication.Remove(LevelName);
+	DormantStreamingLevels.Remove(LevelName);
 }
 
 void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
@@ -918,9 +1316,9 @@ void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::LogNode(FReplicat
 	for (const FName& LevelName : AlwaysRelevantStreamingLevelsNeedingReplication)
 	{
 		UNebulaReplicationGraph* NebulaGraph = CastChecked<UNebulaReplicationGraph>(GetOuter());
-		if (FActorRepListRefView* RepList = NebulaGraph->AlwaysRelevantStreamingLevelActors.Find(LevelName))
+		if (const FNebulaAlwaysRelevantStreamingLevel* Level = NebulaGraph->AlwaysRelevantStreamingLevelActors.Find(LevelName))
 		{
-			LogActorRepList(DebugInfo, FString::Printf(TEXT("AlwaysRelevant StreamingLevel List: %s"), *LevelName.ToString()), *RepList);
+			LogActorRepList(DebugInfo, FString::Printf(TEXT("AlwaysRelevant StreamingLevel List: %s (%d non dormant)"), *LevelName.ToString(), Level->NumNonDormant), Level->Actors);
 		}
 	}
 
@@ -929,91 +1327,361 @@ void UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection::LogNode(FReplicat
 
 // ------------------------------------------------------------------------------
 
-UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter()
-{
-	bRequiresPrepareForReplicationCall = true;
-}
-
-void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::PrepareForReplication()
+void UNebulaReplicationGraphNode_DedupGatheredLists_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
 {
-	ReplicationActorLists.Reset();
-	ForceNetUpdateReplicationActorList.Reset();
+	UNebulaReplicationGraph* NebulaGraph = Nebula::RepGraph::DedupGatheredLists > 0 ? Cast<UNebulaReplicationGraph>(GraphGlobals->ReplicationGraph) : nullptr;
+	if (NebulaGraph == nullptr || Params.OutGatheredReplicationLists.NumLists() <= 1)
+	{
+		return;
+	}
 
-	ReplicationActorLists.AddDefaulted();
-	FActorRepListRefView* CurrentList = &ReplicationActorLists[0];
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_DedupGatheredLists);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, DedupGatheredLists);
 
-	// We rebuild our lists of player states each frame. This is not as efficient as it could be but its the simplest way
-	// to handle players disconnecting and keeping the lists compact. If the lists were persistent we would need to defrag them as players left.
+	TBitArray<>& Seen = NebulaGraph->GatheredActorDedupBits;
+	int32 NumDuplicates = 0;
 
-	for (TActorIterator<APlayerState> It(GetWorld()); It; ++It)
+	for (int32 FlagIdx = 0; FlagIdx < (int32)EActorRepListTypeFlags::Max; ++FlagIdx)
 	{
-		APlayerState* PS = *It;
-		if (IsActorValidForReplicationGather(PS) == false)
+		FActorRepListRefView& DedupedList = DedupedLists[FlagIdx];
+		DedupedList.Reset(DedupedList.Num());
+
+		for (const FActorRepListConstView& List : Params.OutGatheredReplicationLists.GetLists((EActorRepListTypeFlags)FlagIdx))
 		{
-			continue;
+			for (FActorRepListType Actor : List)
+			{
+				const int32 Index = Actor->GetUniqueID();
+				if (Index >= Seen.Num())
+				{
+					// Object indices are dense, grow with headroom so a new actor rarely reallocates.
+					Seen.Add(false, FMath::Max(Index + 1, Seen.Num() * 2) - Seen.Num());
+				}
+
+				FBitReference Bit = Seen[Index];
+				if (Bit)
+				{
+					++NumDuplicates;
+					continue;
+				}
+
+				Bit = true;
+				DedupedList.Add(Actor);
+			}
 		}
 
-		if (CurrentList->Num() >= TargetActorsPerFrame)
+		// Clear only what was set, so the cost stays proportional to the gathered actors.
+		for (FActorRepListType Actor : DedupedList)
 		{
-			ReplicationActorLists.AddDefaulted();
-			CurrentList = &ReplicationActorLists.Last();
+			Seen[Actor->GetUniqueID()] = false;
 		}
-
-		CurrentList->Add(PS);
 	}
-}
 
-void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
-{
-	const int32 ListIdx = Params.ReplicationFrameNum % ReplicationActorLists.Num();
-	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorLists[ListIdx]);
+	NEBULA_REPGRAPH_COUNT(GatheredDuplicatesRemoved, NumDuplicates);
 
-	if (ForceNetUpdateReplicationActorList.Num() > 0)
+	Params.OutGatheredReplicationLists.Reset();
+	for (int32 FlagIdx = 0; FlagIdx < (int32)EActorRepListTypeFlags::Max; ++FlagIdx)
 	{
-		Params.OutGatheredReplicationLists.AddReplicationActorList(ForceNetUpdateReplicationActorList);
+		if (DedupedLists[FlagIdx].Num() > 0)
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(DedupedLists[FlagIdx], (EActorRepListTypeFlags)FlagIdx);
+		}
 	}
 }
 
-void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+// ------------------------------------------------------------------------------
+
+UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter()
 {
-	DebugInfo.Log(NodeName);
-	DebugInfo.PushIndent();
+	bRequiresPrepareForReplicationCall = true;
+}
 
-	int32 i = 0;
-	for (const FActorRepListRefView& List : ReplicationActorLists)
-	{
-		LogActorRepList(DebugInfo, FString::Printf(TEXT("Bucket[%d]"), i++), List);
-	}
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	PlayerStates.Add(ActorInfo.Actor);
+	PlayerStateRepInfos.Add(&GraphGlobals->GlobalActorReplicationInfoMap->Get(ActorInfo.Actor));
 
-	DebugInfo.PopIndent();
+	// Bucketed on the next PrepareForReplication : adding to a list, or a list to the buckets, would move lists already handed out this frame.
 }
 
-void UNebulaReplicationGraph::PrintRepNodePolicies()
+bool UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
 {
-	UEnum* Enum = StaticEnum<EClassRepNodeMapping>();
-	if (!Enum)
+	const int32 Index = PlayerStates.Find(ActorInfo.Actor);
+	if (Index == INDEX_NONE)
 	{
-		return;
+		UE_CLOG(bWarnIfNotFound, LogNebulaRepGraph, Warning, TEXT("UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyRemoveNetworkActor - %s was not tracked."), *GetActorRepListTypeDebugString(ActorInfo.Actor));
+		return false;
 	}
 
-	GLog->Logf(TEXT("===================================="));
-	GLog->Logf(TEXT("Nebula Replication Routing Policies"));
-	GLog->Logf(TEXT("===================================="));
-
-	for (auto It = ClassRepNodePolicies.CreateIterator(); It; ++It)
-	{
-		FObjectKey ObjKey = It.Key();
+	PlayerStates.RemoveAtSwap(Index);
+	PlayerStateRepInfos.RemoveAtSwap(Index);
 
-		EClassRepNodeMapping Mapping = It.Value();
+	// Lists may already be handed out this frame, so compact on the next PrepareForReplication.
+	bBucketsDirty = true;
+	return true;
+}
 
-		GLog->Logf(TEXT("%-40s --> %s"), *GetNameSafe(ObjKey.ResolveObjectPtr()), *Enum->GetNameStringByValue(static_cast<uint32>(Mapping)));
-	}
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::NotifyResetAllNetworkActors()
+{
+	PlayerStates.Reset();
+	PlayerStateRepInfos.Reset();
+	ForceNetUpdateReplicationActorList.Reset();
+	NumBucketedPlayerStates = 0;
+	bBucketsDirty = true;
 }
 
-// ------------------------------------------------------------------------------
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::RebuildBuckets()
+{
+	bBucketsDirty = false;
+	BucketedTargetActorsPerFrame = FMath::Max(TargetActorsPerFrame, 1);
 
-UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D()
-	: CellSize(0.f)
+	NumBucketedPlayerStates = PlayerStates.Num();
+
+	const int32 NumBuckets = FMath::Max(FMath::DivideAndRoundUp(PlayerStates.Num(), BucketedTargetActorsPerFrame), 1);
+	ReplicationActorLists.SetNum(NumBuckets);
+
+	for (int32 BucketIdx = 0; BucketIdx < NumBuckets; ++BucketIdx)
+	{
+		FActorRepListRefView& List = ReplicationActorLists[BucketIdx];
+		List.Reset();
+
+		const int32 End = FMath::Min((BucketIdx + 1) * BucketedTargetActorsPerFrame, PlayerStates.Num());
+		for (int32 Index = BucketIdx * BucketedTargetActorsPerFrame; Index < End; ++Index)
+		{
+			List.Add(PlayerStates[Index]);
+		}
+	}
+}
+
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::BucketNewPlayerStates()
+{
+	for (; NumBucketedPlayerStates < PlayerStates.Num(); ++NumBucketedPlayerStates)
+	{
+		if (ReplicationActorLists.Num() == 0 || ReplicationActorLists.Last().Num() >= BucketedTargetActorsPerFrame)
+		{
+			ReplicationActorLists.AddDefaulted();
+		}
+		ReplicationActorLists.Last().Add(PlayerStates[NumBucketedPlayerStates]);
+	}
+}
+
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::UpdateBudget()
+{
+	const UNetDriver* NetDriver = GraphGlobals->ReplicationGraph->NetDriver;
+	const float TickRate = FMath::Max(NetDriver ? NetDriver->GetNetServerMaxTickRate() : 30.f, 1.f);
+	const float EstimatedBytes = (float)FMath::Max(Nebula::RepGraph::PlayerStateEstimatedBytes, 1);
+	const float BudgetBytesPerFrame = FMath::Max(Nebula::RepGraph::PlayerStateKBytesSec * 1024.f / TickRate, EstimatedBytes);
+
+	// As many as needed for the desired full pass, but never more than the budget : beyond that passes just get longer.
+	const int32 BudgetActorsPerFrame = FMath::Max(FMath::FloorToInt32(BudgetBytesPerFrame / EstimatedBytes), 1);
+	const int32 DesiredCycleFrames = FMath::Max(FMath::RoundToInt32(Nebula::RepGraph::PlayerStateFullCycleSeconds * TickRate), 1);
+	TargetActorsPerFrame = FMath::Clamp(FMath::DivideAndRoundUp(PlayerStates.Num(), DesiredCycleFrames), 1, BudgetActorsPerFrame);
+
+	// The owner's PlayerState gets what is left of the budget. Full rate while the rolling subset is small, throttled as it fills the budget.
+	OwnerPlayerStateReplicationPeriod = FMath::Max(FMath::CeilToInt32((TargetActorsPerFrame + 1) * EstimatedBytes / BudgetBytesPerFrame), 1);
+}
+
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::PrepareForReplication()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_PlayerState_Prepare);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, PlayerState_Prepare);
+
+	UpdateBudget();
+
+	if (bBucketsDirty || BucketedTargetActorsPerFrame != FMath::Max(TargetActorsPerFrame, 1))
+	{
+		RebuildBuckets();
+	}
+	else
+	{
+		BucketNewPlayerStates();
+	}
+
+	// ForceNetUpdate stamps the current graph frame, which is the frame of our last prepare if it was called during the game tick since then.
+	const uint32 ReplicationFrame = GraphGlobals->ReplicationGraph->GetReplicationGraphFrame();
+	ForceNetUpdateReplicationActorList.Reset();
+	for (int32 Index = 0; Index < PlayerStates.Num(); ++Index)
+	{
+		if (PlayerStateRepInfos[Index]->ForceNetUpdateFrame >= LastPreparedFrame && LastPreparedFrame > 0)
+		{
+			ForceNetUpdateReplicationActorList.Add(PlayerStates[Index]);
+		}
+	}
+	LastPreparedFrame = ReplicationFrame;
+}
+
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_PlayerState_Gather);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, PlayerState_Gather);
+
+	const int32 ListIdx = Params.ReplicationFrameNum % ReplicationActorLists.Num();
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorLists[ListIdx]);
+
+	if (ForceNetUpdateReplicationActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ForceNetUpdateReplicationActorList);
+		NEBULA_REPGRAPH_COUNT(PlayerStateListsEmitted, 2);
+	}
+	else
+	{
+		NEBULA_REPGRAPH_COUNT(PlayerStateListsEmitted, 1);
+	}
+}
+
+void UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(NodeName);
+	DebugInfo.PushIndent();
+
+	int32 i = 0;
+	for (const FActorRepListRefView& List : ReplicationActorLists)
+	{
+		LogActorRepList(DebugInfo, FString::Printf(TEXT("Bucket[%d]"), i++), List);
+	}
+
+	DebugInfo.PopIndent();
+}
+
+void UNebulaReplicationGraph::PrintRepNodePolicies()
+{
+	UEnum* Enum = StaticEnum<EClassRepNodeMapping>();
+	if (!Enum)
+	{
+		return;
+	}
+
+	GLog->Logf(TEXT("===================================="));
+	GLog->Logf(TEXT("Nebula Replication Routing Policies"));
+	GLog->Logf(TEXT("===================================="));
+
+	for (auto It = ClassRepNodePolicies.CreateIterator(); It; ++It)
+	{
+		FObjectKey ObjKey = It.Key();
+
+		EClassRepNodeMapping Mapping = It.Value();
+
+		GLog->Logf(TEXT("%-40s --> %s"), *GetNameSafe(ObjKey.ResolveObjectPtr()), *Enum->GetNameStringByValue(static_cast<uint32>(Mapping)));
+	}
+}
+
+namespace Nebula::RepGraph
+{
+	// Buckets are 0, 1, 2-3, 4-7, ... so a few crowded cells stand out next to thousands of empty ones.
+	static void PrintHistogram(const TCHAR* Title, TConstArrayView<int32> Values)
+	{
+		TArray<int32, TInlineAllocator<16>> Buckets;
+		for (const int32 Value : Values)
+		{
+			const int32 Bucket = Value <= 0 ? 0 : (int32)FMath::FloorLog2((uint32)Value) + 1;
+			if (Buckets.Num() <= Bucket)
+			{
+				Buckets.SetNumZeroed(Bucket + 1);
+			}
+			++Buckets[Bucket];
+		}
+
+		GLog->Logf(TEXT("  %s (%d cells)"), Title, Values.Num());
+		for (int32 Bucket = 0; Bucket < Buckets.Num(); ++Bucket)
+		{
+			const int32 Min = Bucket == 0 ? 0 : 1 << (Bucket - 1);
+			const int32 Max = Bucket == 0 ? 0 : (1 << Bucket) - 1;
+			const FString Range = Min == Max ? FString::FromInt(Min) : FString::Printf(TEXT("%d-%d"), Min, Max);
+			GLog->Logf(TEXT("    %-12s : %8d  %5.1f%%"), *Range, Buckets[Bucket], Values.Num() > 0 ? 100.f * Buckets[Bucket] / Values.Num() : 0.f);
+		}
+	}
+
+	static FString BytesToString(SIZE_T Bytes)
+	{
+		return Bytes >= 1024 * 1024 ? FString::Printf(TEXT("%.2f MB"), Bytes / (1024.0 * 1024.0)) : FString::Printf(TEXT("%.1f KB"), Bytes / 1024.0);
+	}
+}
+
+void UNebulaReplicationGraph::PrintMemoryReport() const
+{
+	using namespace Nebula::RepGraph;
+
+	GLog->Logf(TEXT("===================================="));
+	GLog->Logf(TEXT("Nebula Replication Graph Memory"));
+	GLog->Logf(TEXT("===================================="));
+
+	// Lists and maps of the engine don't expose their capacity, entries are counted at their element size.
+	GLog->Logf(TEXT("Global : %d actors in GlobalActorReplicationInfoMap, ~%s"), GlobalActorReplicationInfoMap.Num(), *BytesToString(GlobalActorReplicationInfoMap.Num() * sizeof(FGlobalActorReplicationInfo)));
+
+	if (GridNode)
+	{
+		const TArray<UReplicationGraphNode*>& GridCells = GridNode->GetAllChildNodes();
+		TArray<int32> ActorsPerCell;
+		ActorsPerCell.Reserve(GridCells.Num());
+
+		TArray<FActorRepListType> CellActors;
+		for (const UReplicationGraphNode* GridCell : GridCells)
+		{
+			CellActors.Reset();
+			GridCell->GetAllActorsInNode_Debugging(CellActors);
+			ActorsPerCell.Add(CellActors.Num());
+		}
+
+		GLog->Logf(TEXT("GridSpatialization2D : %d GridCells, %d actors, %s of GridCell nodes (%d bytes each)"), GridCells.Num(), Algo::Accumulate(ActorsPerCell, 0),
+			*BytesToString(GridCells.Num() * sizeof(UReplicationGraphNode_GridCell)), (int32)sizeof(UReplicationGraphNode_GridCell));
+		PrintHistogram(TEXT("GridSpatialization2D actors per GridCell"), ActorsPerCell);
+	}
+
+	int32 NumStreamingLevelActors = 0;
+	int32 NumNonDormantStreamingLevelActors = 0;
+	SIZE_T StreamingLevelSize = AlwaysRelevantStreamingLevelActors.GetAllocatedSize();
+	for (const TPair<FName, FNebulaAlwaysRelevantStreamingLevel>& It : AlwaysRelevantStreamingLevelActors)
+	{
+		NumStreamingLevelActors += It.Value.Actors.Num();
+		NumNonDormantStreamingLevelActors += It.Value.NumNonDormant;
+		StreamingLevelSize += It.Value.Actors.Num() * sizeof(FActorRepListType);
+	}
+	GLog->Logf(TEXT("AlwaysRelevant streaming levels : %d levels, %d actors (%d non dormant), %s"), AlwaysRelevantStreamingLevelActors.Num(), NumStreamingLevelActors,
+		NumNonDormantStreamingLevelActors, *BytesToString(StreamingLevelSize));
+
+	if (PVSGridNode)
+	{
+		PVSGridNode->PrintMemoryReport();
+	}
+
+	if (PVSTeamNode)
+	{
+		GLog->Logf(TEXT("PVS team vision : %d teams, %s"), PVSTeamNode->GetNumTeams(), *BytesToString(PVSTeamNode->GetAllocatedSize()));
+	}
+
+	// Per connection caches. ActorInfoMap grows with every actor ever gathered for the connection, it is usually the largest.
+	GLog->Logf(TEXT("Connections : %d (+%d pending)"), Connections.Num(), PendingConnections.Num());
+
+	SIZE_T TotalConnectionSize = 0;
+	for (const UNetReplicationGraphConnection* ConnManager : Connections)
+	{
+		const SIZE_T ActorInfoSize = ConnManager->ActorInfoMap.Num() * sizeof(FConnectionReplicationActorInfo);
+		TotalConnectionSize += ActorInfoSize;
+
+		FString AlwaysRelevantString;
+		for (const UReplicationGraphNode* ConnectionNode : ConnManager->GetConnectionGraphNodes())
+		{
+			if (const UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantConnectionNode = Cast<UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection>(ConnectionNode))
+			{
+				TotalConnectionSize += AlwaysRelevantConnectionNode->GetAllocatedSize();
+				AlwaysRelevantString = FString::Printf(TEXT(", PastRelevantActorMap %d, streaming levels %d active / %d dormant, %s"), AlwaysRelevantConnectionNode->GetNumPastRelevantActors(),
+					AlwaysRelevantConnectionNode->GetNumActiveStreamingLevels(), AlwaysRelevantConnectionNode->GetNumDormantStreamingLevels(), *BytesToString(AlwaysRelevantConnectionNode->GetAllocatedSize()));
+			}
+		}
+
+		GLog->Logf(TEXT("  %-32s : ActorInfoMap %d entries ~%s%s"), *GetNameSafe(ConnManager->NetConnection), ConnManager->ActorInfoMap.Num(), *BytesToString(ActorInfoSize), *AlwaysRelevantString);
+	}
+	GLog->Logf(TEXT("Connections total : ~%s"), *BytesToString(TotalConnectionSize));
+
+	if (const UNebulaPVSNetObjectFilter* PVSFilter = UNebulaPVSNetObjectFilter::FindForWorld(GetWorld()))
+	{
+		GLog->Logf(TEXT("Iris PVS filter : %s"), *BytesToString(PVSFilter->GetAllocatedSize()));
+	}
+}
+
+// ------------------------------------------------------------------------------
+
+UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D()
+	: CellSize(0.f)
 	, SpatialBias(ForceInitToZero)
 {
 	bRequiresPrepareForReplicationCall = true;
@@ -1036,207 +1704,1659 @@ bool UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::NotifyActorRename
 	return false;
 }
 
-void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::PrepareForReplication()
+int32 UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::FDynamicActorArrays::Add(const FNewReplicatedActorInfo& InActorInfo, FGlobalActorReplicationInfo* InRepInfo)
+{
+	const int32 Index = Actors.Add(InActorInfo.Actor);
+	RepInfos.Add(InRepInfo);
+	Locations.Add(FVector::ZeroVector);
+	Cells.AddDefaulted();
+	NewCells.AddDefaulted();
+	ActorInfos.Add(InActorInfo);
+	MovementSources.AddDefaulted();
+	Moved.Add(false);
+	return Index;
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::FDynamicActorArrays::RemoveAtSwap(int32 Index)
+{
+	Actors.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	RepInfos.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Locations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Cells.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	NewCells.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	ActorInfos.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	MovementSources.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Moved.RemoveAtSwap(Index);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::FDynamicActorArrays::Reset()
 {
-	FGlobalActorReplicationInfoMap* GlobalRepMap = GraphGlobals.IsValid() ? GraphGlobals->GlobalActorReplicationInfoMap : nullptr;
-	check(GlobalRepMap);
+	Actors.Reset();
+	RepInfos.Reset();
+	Locations.Reset();
+	Cells.Reset();
+	NewCells.Reset();
+	ActorInfos.Reset();
+	MovementSources.Reset();
+	Moved.Reset();
+}
 
-	for (auto& MapIt : DynamicSpatializedActors)
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::NotifyResetAllNetworkActors()
+{
+	for (const TWeakObjectPtr<USceneComponent>& MovementSource : DynamicActors.MovementSources)
 	{
-		FActorRepListType& DynamicActor = MapIt.Key;
-		FCachedDynamicActorInfo& DynamicActorInfo = MapIt.Value;
-		FActorCellInfo& PreviousCellInfo = DynamicActorInfo.CellInfo;
-		FNewReplicatedActorInfo& ActorInfo = DynamicActorInfo.ActorInfo;
+		if (USceneComponent* Component = MovementSource.Get())
+		{
+			Component->TransformUpdated.RemoveAll(this);
+		}
+	}
 
-		FGlobalActorReplicationInfo& ActorRepInfo = GlobalRepMap->Get(DynamicActor);
-		ActorRepInfo.WorldLocation = DynamicActor->GetActorLocation();
+	DynamicActors.Reset();
+	DynamicActorIndices.Reset();
+	MovedDynamicActors.Reset();
+	DynamicCellChanges.Reset();
+	StaticSpatializedActors.Reset();
+
+	OccupiedCells.Reset();
+	StaticOccupiedCells.Reset();
+	DormantCells.Reset();
+	bStaticOccupancyDirty = true;
+	SharedViewerCellLists.Reset();
+	PendingSharedLists.Reset();
+	bAudibleOccupancyDirty = true;
+
+	// Per connection caches only hold actors of the old world.
+	MultiViewerLists.Reset();
+	AudibleLists.Reset();
+	DistanceTierStates.Reset();
+	PausedChannels.Reset();
+
+	// GridCells and the overflow cell.
+	Super::NotifyResetAllNetworkActors();
+}
 
-		const int32 GridCellX = UE::LWC::FloatToIntCastChecked<int32>((ActorRepInfo.WorldLocation.X - SpatialBias.X) / CellSize);
-		const int32 GridCellY = UE::LWC::FloatToIntCastChecked<int32>((ActorRepInfo.WorldLocation.Y - SpatialBias.Y) / CellSize);
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::PrepareForReplication()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_PVS_Prepare);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, PVS_Prepare);
 
-		FActorCellInfo NewCellInfo;
-		NewCellInfo.CellIndex.X = GridCellX;
-		NewCellInfo.CellIndex.Y = GridCellY;
+	// Between replication frames : nothing gathered from the old table is still in use.
+	if (PendingLookupTable.IsValid() && PendingLookupTable.IsReady())
+	{
+		ApplyPendingLookupTable();
+	}
 
-		const FIntPoint& PreviousCell = PreviousCellInfo.CellIndex;
+	DynamicCellChanges.Reset();
 
-		if (PreviousCellInfo.IsValid())
+	if (bUseEventDrivenUpdates)
+	{
+		for (FActorRepListType DynamicActor : MovedDynamicActors)
 		{
-			if (UNLIKELY((PreviousCell.X != GridCellX) || (PreviousCell.Y != GridCellY)))
+			// May have been removed since it moved.
+			if (const int32* Index = DynamicActorIndices.Find(DynamicActor))
 			{
-				UE_LOG(LogNebulaRepGraph, Warning, TEXT("Dynamic Actor %s : {%d, %d} -> {%d, %d}"),
-					*DynamicActor->GetName(), PreviousCell.X, PreviousCell.Y, GridCellX, GridCellY);
+				DynamicActors.Moved[*Index] = false;
+				UpdateDynamicActorCell(*Index);
+			}
+		}
+		MovedDynamicActors.Reset();
+	}
+	else
+	{
+		const int32 NumDynamicActors = DynamicActors.Num();
 
-				if (UReplicationGraphNode_GridCell* PreviousGridCell = GetCell(PreviousCell.X, PreviousCell.Y))
-				{
-					PreviousGridCell->RemoveDynamicActor(ActorInfo);
-				}
+		// 1) Read locations. This is the only pass that chases actor pointers.
+		for (int32 Index = 0; Index < NumDynamicActors; ++Index)
+		{
+			const FVector Location = DynamicActors.Actors[Index]->GetActorLocation();
+			DynamicActors.Locations[Index] = Location;
+			DynamicActors.RepInfos[Index]->WorldLocation = Location;
+		}
 
-				if (UReplicationGraphNode_GridCell* CurrentGridCell = GetCellNode(GetCell(GridCellX, GridCellY)))
-				{
-					CurrentGridCell->AddDynamicActor(ActorInfo);
-				}
+		// 2) Recompute cells. One vectorized pass over contiguous arrays.
+		PVSGrid.GetCells(DynamicActors.Locations, DynamicActors.NewCells);
 
-				PreviousCellInfo = NewCellInfo;
-			}
-#if 0
-			else
+		// 3) Re-bucket the few that changed.
+		for (int32 Index = 0; Index < NumDynamicActors; ++Index)
+		{
+			if (UNLIKELY(DynamicActors.NewCells[Index] != DynamicActors.Cells[Index]) && HasLeftCell(Index))
 			{
-				// NOP : nothing has changed. 
+				MoveDynamicActorCell(Index);
 			}
-#endif
 		}
-		else
+	}
+
+	if (bUseSharedGatherLists)
+	{
+		BuildSharedGatherLists();
+	}
+
+	// Drop audible lists of connections that stopped gathering (disconnected, or the tier got disabled).
+	const uint32 ReplicationFrame = GraphGlobals->ReplicationGraph->GetReplicationGraphFrame();
+	const uint32 AudibleListTimeout = 2 * FMath::Max(Nebula::RepGraph::PVSAudibleReplicationPeriod, 1);
+	for (auto It = MultiViewerLists.CreateIterator(); It; ++It)
+	{
+		if (ReplicationFrame - It.Value().BuiltFrame > 2)
 		{
-			// First time - Just add
-			if (UReplicationGraphNode_GridCell* CurrentGridCell = GetCellNode(GetCell(GridCellX, GridCellY)))
-			{
-				CurrentGridCell->AddDynamicActor(ActorInfo);
-			}
+			It.RemoveCurrent();
+		}
+	}
 
-			PreviousCellInfo = NewCellInfo;
+	for (auto It = AudibleLists.CreateIterator(); It; ++It)
+	{
+		if (ReplicationFrame - It.Value().BuiltFrame > AudibleListTimeout)
+		{
+			It.RemoveCurrent();
 		}
 	}
-}
 
-/**
-* 1) Get ViewTarget's Grid index from WorldLocation (imagine First Person, but use ViewLocation in Params.Viewers if Third Person)
-* 2) Find visible GridCells from LookupTable
-* 3) Gather by iterating visible GridCells
-*/
-void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
-{
-	// $TODO : replace DynamicSpatializedActor with ViewTarget, but in prototype, viewtarget is ok
-	if (AActor* ViewTarget = Params.ConnectionManager.NetConnection->ViewTarget)
+	for (auto It = DistanceTierStates.CreateIterator(); It; ++It)
 	{
-		FGlobalActorReplicationInfoMap* GlobalRepMap = GraphGlobals.IsValid() ? GraphGlobals->GlobalActorReplicationInfoMap : nullptr;
-		FGlobalActorReplicationInfo& ActorRepInfo = GlobalRepMap->Get(ViewTarget);
-		
-		const int32 GridCellX = UE::LWC::FloatToIntCastChecked<int32>((ActorRepInfo.WorldLocation.X - SpatialBias.X) / CellSize);
-		const int32 GridCellY = UE::LWC::FloatToIntCastChecked<int32>((ActorRepInfo.WorldLocation.Y - SpatialBias.Y) / CellSize);
-		
-		if (const TArray<FIntPoint>* VisibleCells = PVSLookupTable.Find(FIntPoint(GridCellX, GridCellY)))
+		if (ReplicationFrame - It.Value().BuiltFrame > 2)
 		{
-			for (const FIntPoint& Cell : *VisibleCells)
-			{
-				// $TODO : iter/calling GatherActorListsForConnection on all visible cells per Connection would heavy?
-				if (UReplicationGraphNode_GridCell* GridCell = GetCellNode(GetCell(Cell.X, Cell.Y)))
-				{
-					GridCell->GatherActorListsForConnection(Params);
-				}
-			}
+			It.RemoveCurrent();
+		}
+	}
+
+	for (auto It = PausedChannels.CreateIterator(); It; ++It)
+	{
+		if (ReplicationFrame - It.Value().BuiltFrame > 2)
+		{
+			It.RemoveCurrent();
 		}
 	}
 }
 
-void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::AddActorInternal_Dynamic(const FNewReplicatedActorInfo& ActorInfo)
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::UpdateDynamicActorCell(int32 Index)
 {
-	UE_LOG(LogNebulaRepGraph, Warning, TEXT("Dynamic Actor : %s is Added in PrecomputedVisibilityGrid2D Node."), *ActorInfo.Actor->GetName());
-	DynamicSpatializedActors.Emplace(ActorInfo.Actor, ActorInfo);
+	const FVector Location = DynamicActors.Actors[Index]->GetActorLocation();
+	DynamicActors.Locations[Index] = Location;
+	DynamicActors.RepInfos[Index]->WorldLocation = Location;
+	DynamicActors.NewCells[Index] = GetCellForLocation(Location);
+
+	if (DynamicActors.NewCells[Index] != DynamicActors.Cells[Index] && HasLeftCell(Index))
+	{
+		MoveDynamicActorCell(Index);
+	}
 }
 
-void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::RemoveActorInternal_Dynamic(const FNewReplicatedActorInfo& ActorInfo)
+bool UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::HasLeftCell(int32 Index) const
 {
-	if (FCachedDynamicActorInfo* DynamicActorInfo = DynamicSpatializedActors.Find(ActorInfo.Actor))
+	return PVSGrid.HasLeftCell(DynamicActors.Locations[Index], DynamicActors.Cells[Index], Nebula::RepGraph::PVSCellHysteresis);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::MoveDynamicActorCell(int32 Index)
+{
+	FNewReplicatedActorInfo& ActorInfo = DynamicActors.ActorInfos[Index];
+	const FNebulaCellId PreviousCell = DynamicActors.Cells[Index];
+	const FNebulaCellId NewCell = DynamicActors.NewCells[Index];
+
+	// Shared gather lists pick dynamic actors up from DynamicActors, they don't live in GridCells.
+	if (PreviousCell.IsValid())
 	{
-		if (DynamicActorInfo->CellInfo.IsValid())
+		if (Nebula::RepGraph::PVSPauseFrames > 0)
 		{
-			const int32 GridCellX = DynamicActorInfo->CellInfo.CellIndex.X;
-			const int32 GridCellY = DynamicActorInfo->CellInfo.CellIndex.Y;
+			DynamicCellChanges.Emplace(ActorInfo.Actor, PreviousCell);
+		}
+
+		if (UNLIKELY(Nebula::RepGraph::PVSLogCellChanges > 0))
+		{
+			UE_LOG(LogNebulaRepGraph, Display, TEXT("Dynamic Actor %s : %s -> %s"),
+				*ActorInfo.Actor->GetName(), *PreviousCell.ToString(), *NewCell.ToString());
+		}
 
-			if (UReplicationGraphNode_GridCell* GridCell = GetCell(GetGridX(GridCellX), GridCellY))
+		if (LivesInGridCell(PreviousCell))
+		{
+			if (UReplicationGraphNode_GridCell* PreviousGridCell = FindCell(PreviousCell))
 			{
-				GridCell->RemoveDynamicActor(ActorInfo);
+				PreviousGridCell->RemoveDynamicActor(ActorInfo);
 			}
 		}
-		DynamicSpatializedActors.Remove(ActorInfo.Actor);
 	}
-	UE_LOG(LogNebulaRepGraph, Warning, TEXT("Dynamic Actor : %s is Removed in PrecomputedVisibilityGrid2D Node."), *ActorInfo.Actor->GetName());
+
+	// First time - Just add
+	if (LivesInGridCell(NewCell))
+	{
+		if (UReplicationGraphNode_GridCell* CurrentGridCell = GetCellNode(GetCell(NewCell)))
+		{
+			CurrentGridCell->AddDynamicActor(ActorInfo);
+		}
+	}
+
+	DynamicActors.Cells[Index] = NewCell;
+	NEBULA_REPGRAPH_COUNT(PVSActorsRebucketed, 1);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::OnDynamicActorTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (const int32* Index = DynamicActorIndices.Find(UpdatedComponent->GetOwner()))
+	{
+		if (!DynamicActors.Moved[*Index])
+		{
+			DynamicActors.Moved[*Index] = true;
+			MovedDynamicActors.Add(UpdatedComponent->GetOwner());
+		}
+	}
 }
 
-void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GenerateLookupTable()
+bool UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GetViewerCell(const UNetConnection* NetConnection, FNebulaCellId& OutCell, FVector* OutLocation) const
 {
-	PVSLookupTable.Reset();
-	// ------------------------------------
-	// TestCase
-	// SpatialBias = -600, CellSize : 200
-	// ------------------------------------
-	const int32 NumToReserve = (SpatialBias.X * 2 / CellSize) * (SpatialBias.Y * 2 / CellSize);
-	PVSLookupTable.Reserve(NumToReserve);
+	AActor* ViewTarget = NetConnection ? NetConnection->ViewTarget : nullptr;
+	if (ViewTarget == nullptr)
+	{
+		return false;
+	}
 
-	// max memory usage : O(N^3) * 8bytes?, need to compress data structure (ex : FIntPoint to uint16, ...)
-	// cuz memory footprint...
-	
-	// --------------------------------
-	//	grid cells brief specification
-	//					  (6, 6)
-	//		□□□□□□■
-	//		□□□□□□□
-	//		□□□□□□□
-	//		□□□□□□□
-	//		□□□□□□□
-	//		□□□□□□□
-	//		■□□□□□□
-	// (0,0)
-	// --------------------------------
+	// Same as FNetViewer : the player's view point if there is a controller, so a third person camera resolves to the cell it actually sees from.
+	FVector ViewLocation = ViewTarget->GetActorLocation();
+	if (const APlayerController* PC = NetConnection->PlayerController)
+	{
+		FRotator ViewRotation;
+		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	}
 
-	// ---------------------------------------------------------------------------------
-	// | ViewTarget in key(0, 0) can see value({0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}) |
-	// | $TODO : Generate all visibility info.                                         |
-	// ---------------------------------------------------------------------------------
-	PVSLookupTable.Add({ FIntPoint(0, 0), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // ■□□□□□□
-	PVSLookupTable.Add({ FIntPoint(0, 1), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // ■□□□□□□
-	PVSLookupTable.Add({ FIntPoint(0, 2), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // ■□□□□□□
-	PVSLookupTable.Add({ FIntPoint(0, 3), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // ■□□□□□□
-	PVSLookupTable.Add({ FIntPoint(0, 4), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // ■□□□□□□
-	PVSLookupTable.Add({ FIntPoint(0, 5), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // ■□□□□□□
-	PVSLookupTable.Add({ FIntPoint(0, 6), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // ■□□□□□□
-
-	PVSLookupTable.Add({ FIntPoint(1, 0), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □■□□□□□
-	PVSLookupTable.Add({ FIntPoint(1, 1), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □■□□□□□
-	PVSLookupTable.Add({ FIntPoint(1, 2), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □■□□□□□
-	PVSLookupTable.Add({ FIntPoint(1, 3), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □■□□□□□
-	PVSLookupTable.Add({ FIntPoint(1, 4), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □■□□□□□
-	PVSLookupTable.Add({ FIntPoint(1, 5), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □■□□□□□
-	PVSLookupTable.Add({ FIntPoint(1, 6), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □■□□□□□
-
-	PVSLookupTable.Add({ FIntPoint(2, 0), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□■□□□□
-	PVSLookupTable.Add({ FIntPoint(2, 1), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□■□□□□
-	PVSLookupTable.Add({ FIntPoint(2, 2), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□■□□□□
-	PVSLookupTable.Add({ FIntPoint(2, 3), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□■□□□□
-	PVSLookupTable.Add({ FIntPoint(2, 4), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□■□□□□
-	PVSLookupTable.Add({ FIntPoint(2, 5), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□■□□□□
-	PVSLookupTable.Add({ FIntPoint(2, 6), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□■□□□□
-
-	PVSLookupTable.Add({ FIntPoint(3, 0), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□■□□□
-	PVSLookupTable.Add({ FIntPoint(3, 1), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□■□□□
-	PVSLookupTable.Add({ FIntPoint(3, 2), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□■□□□
-	PVSLookupTable.Add({ FIntPoint(3, 3), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□■□□□
-	PVSLookupTable.Add({ FIntPoint(3, 4), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□■□□□
-	PVSLookupTable.Add({ FIntPoint(3, 5), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□■□□□
-	PVSLookupTable.Add({ FIntPoint(3, 6), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□■□□□
-
-	PVSLookupTable.Add({ FIntPoint(4, 0), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□■□□
-	PVSLookupTable.Add({ FIntPoint(4, 1), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□■□□
-	PVSLookupTable.Add({ FIntPoint(4, 2), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□■□□
-	PVSLookupTable.Add({ FIntPoint(4, 3), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□■□□
-	PVSLookupTable.Add({ FIntPoint(4, 4), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□■□□
-	PVSLookupTable.Add({ FIntPoint(4, 5), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□■□□
-	PVSLookupTable.Add({ FIntPoint(4, 6), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□■□□
-
-	PVSLookupTable.Add({ FIntPoint(5, 0), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□■□
-	PVSLookupTable.Add({ FIntPoint(5, 1), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□■□
-	PVSLookupTable.Add({ FIntPoint(5, 2), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□■□
-	PVSLookupTable.Add({ FIntPoint(5, 3), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□■□
-	PVSLookupTable.Add({ FIntPoint(5, 4), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□■□
-	PVSLookupTable.Add({ FIntPoint(5, 5), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□■□
-	PVSLookupTable.Add({ FIntPoint(5, 6), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□■□
-
-	PVSLookupTable.Add({ FIntPoint(6, 0), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□□■
-	PVSLookupTable.Add({ FIntPoint(6, 1), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□□■
-	PVSLookupTable.Add({ FIntPoint(6, 2), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□□■
-	PVSLookupTable.Add({ FIntPoint(6, 3), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□□■
-	PVSLookupTable.Add({ FIntPoint(6, 4), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□□■
-	PVSLookupTable.Add({ FIntPoint(6, 5), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□□■
-	PVSLookupTable.Add({ FIntPoint(6, 6), TArray<FIntPoint>({ {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}}) }); // □□□□□□■
-}
\ No newline at end of file
+	OutCell = GetCellForLocation(ViewLocation);
+	if (OutLocation)
+	{
+		*OutLocation = ViewLocation;
+	}
+	return true;
+}
+
+bool UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::IsAudible(const FVector& ViewerLocation, const FVector& ActorLocation) const
+{
+	return Nebula::RepGraph::PVSAudibleRange > 0.f && FVector::DistSquared2D(ViewerLocation, ActorLocation) <= FMath::Square(Nebula::RepGraph::PVSAudibleRange);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GatherAudibleActors(const FConnectionGatherActorListParameters& Params, const FViewerVisibility& Visibility, TConstArrayView<FVector> ViewerLocations)
+{
+	const int32 Period = FMath::Max(Nebula::RepGraph::PVSAudibleReplicationPeriod, 1);
+	if (Nebula::RepGraph::PVSAudibleRange <= 0.f || (Params.ReplicationFrameNum % Period) != 0)
+	{
+		return;
+	}
+
+	FAudibleList& AudibleList = AudibleLists.FindOrAdd(Params.ConnectionManager.NetConnection);
+	AudibleList.ActorList.Reset();
+	AudibleList.BuiltFrame = Params.ReplicationFrameNum;
+
+	if (bAudibleOccupancyDirty || AudibleOccupancyFrame != Params.ReplicationFrameNum)
+	{
+		BuildAudibleOccupancy();
+		AudibleOccupancyFrame = Params.ReplicationFrameNum;
+	}
+
+	// Cells overlapping the audible square of any viewer. Visible ones are already gathered at full rate.
+	// Coarse cells of two-level tables cover several grid coordinates, and viewers may overlap, so cells are made unique before walking them.
+	const double Range = Nebula::RepGraph::PVSAudibleRange;
+	AudibleScratchCells.Reset();
+	for (const FVector& ViewerLocation : ViewerLocations)
+	{
+		const int32 MinX = FMath::Max(FMath::FloorToInt32((ViewerLocation.X - Range - SpatialBias.X) / CellSize), 0);
+		const int32 MinY = FMath::Max(FMath::FloorToInt32((ViewerLocation.Y - Range - SpatialBias.Y) / CellSize), 0);
+		const int32 MaxX = FMath::Min(FMath::FloorToInt32((ViewerLocation.X + Range - SpatialBias.X) / CellSize), PVSTable.GetNumX() - 1);
+		const int32 MaxY = FMath::Min(FMath::FloorToInt32((ViewerLocation.Y + Range - SpatialBias.Y) / CellSize), PVSTable.GetNumY() - 1);
+
+		for (int32 Y = MinY; Y <= MaxY; ++Y)
+		{
+			for (int32 X = MinX; X <= MaxX; ++X)
+			{
+				const int32 CellIndex = PVSTable.GetCellIndex(X, Y);
+				if (!Visibility.IsVisible(CellIndex))
+				{
+					AudibleScratchCells.Add(CellIndex);
+				}
+			}
+		}
+	}
+
+	AudibleScratchCells.Sort();
+	AudibleScratchCells.SetNum(Algo::Unique(AudibleScratchCells), EAllowShrinking::No);
+
+	const AActor* ViewTarget = Params.ConnectionManager.NetConnection->ViewTarget;
+	for (const int32 CellIndex : AudibleScratchCells)
+	{
+		for (int32 Entry = AudibleCellStarts[CellIndex]; Entry < AudibleCellStarts[CellIndex + 1]; ++Entry)
+		{
+			const int32 Index = AudibleCellActors[Entry];
+			const FVector& ActorLocation = DynamicActors.Locations[Index];
+			if (DynamicActors.Actors[Index] == ViewTarget
+				|| !Algo::AnyOf(ViewerLocations, [this, &ActorLocation](const FVector& ViewerLocation) { return IsAudible(ViewerLocation, ActorLocation); }))
+			{
+				continue;
+			}
+
+			AudibleList.ActorList.Add(DynamicActors.Actors[Index]);
+		}
+	}
+
+	if (AudibleList.ActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(AudibleList.ActorList);
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::BuildAudibleOccupancy()
+{
+	bAudibleOccupancyDirty = false;
+
+	// Counting sort : count per cell, running totals, then place each actor by decrementing its cell's total down to the cell's first entry.
+	const int32 NumCells = PVSTable.GetNumCells();
+	AudibleCellStarts.Reset();
+	AudibleCellStarts.SetNumZeroed(NumCells + 1);
+
+	for (const FNebulaCellId Cell : DynamicActors.Cells)
+	{
+		const int32 CellIndex = PVSGrid.GetCellIndex(Cell);
+		if (CellIndex != INDEX_NONE)
+		{
+			++AudibleCellStarts[CellIndex];
+		}
+	}
+
+	for (int32 CellIndex = 1; CellIndex <= NumCells; ++CellIndex)
+	{
+		AudibleCellStarts[CellIndex] += AudibleCellStarts[CellIndex - 1];
+	}
+
+	AudibleCellActors.SetNumUninitialized(AudibleCellStarts[NumCells], EAllowShrinking::No);
+	for (int32 Index = DynamicActors.Num() - 1; Index >= 0; --Index)
+	{
+		const int32 CellIndex = PVSGrid.GetCellIndex(DynamicActors.Cells[Index]);
+		if (CellIndex != INDEX_NONE)
+		{
+			AudibleCellActors[--AudibleCellStarts[CellIndex]] = Index;
+		}
+	}
+}
+
+SIZE_T UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GetAllocatedSize() const
+{
+	SIZE_T Size = DynamicActors.Actors.GetAllocatedSize() + DynamicActors.RepInfos.GetAllocatedSize() + DynamicActors.Locations.GetAllocatedSize()
+		+ DynamicActors.Cells.GetAllocatedSize() + DynamicActors.NewCells.GetAllocatedSize() + DynamicActors.ActorInfos.GetAllocatedSize()
+		+ DynamicActors.MovementSources.GetAllocatedSize() + DynamicActors.Moved.GetAllocatedSize();
+
+	Size += DynamicActorIndices.GetAllocatedSize() + StaticSpatializedActors.GetAllocatedSize() + MovedDynamicActors.GetAllocatedSize();
+	Size += OccupiedCells.GetAllocatedSize() + StaticOccupiedCells.GetAllocatedSize() + DormantCells.GetAllocatedSize();
+	Size += PVSTable.GetAllocatedSize() + FlatGrid.GetAllocatedSize() + Grid.GetAllocatedSize();
+	for (const TArray<UReplicationGraphNode_GridCell*>& GridX : Grid)
+	{
+		Size += GridX.GetAllocatedSize();
+	}
+
+	// Rep lists don't expose their capacity, count what they hold.
+	Size += SharedViewerCellLists.GetAllocatedSize();
+	for (const auto& It : SharedViewerCellLists)
+	{
+		Size += sizeof(FSharedViewerCellList) + (It.Value->ActorList.Num() + It.Value->MidActorList.Num() + It.Value->FarActorList.Num()) * sizeof(FActorRepListType);
+	}
+
+	Size += DistanceTierStates.GetAllocatedSize();
+	for (const auto& It : DistanceTierStates)
+	{
+		Size += It.Value.ReducedActors.GetAllocatedSize();
+	}
+
+	Size += AudibleLists.GetAllocatedSize() + AudibleCellStarts.GetAllocatedSize() + AudibleCellActors.GetAllocatedSize() + AudibleScratchCells.GetAllocatedSize();
+	for (const auto& It : AudibleLists)
+	{
+		Size += It.Value.ActorList.Num() * sizeof(FActorRepListType);
+	}
+
+	Size += PausedChannels.GetAllocatedSize() + DynamicCellChanges.GetAllocatedSize();
+	for (const auto& It : PausedChannels)
+	{
+		Size += It.Value.Actors.GetAllocatedSize() + It.Value.ViewerCellIndices.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::PrintMemoryReport() const
+{
+	using namespace Nebula::RepGraph;
+
+	// Table. Runs per row is what the RLE rows cost, visible cells per row is what a gather walks.
+	const int32 NumCells = PVSTable.GetNumCells();
+	int64 NumRuns = 0;
+	int64 NumVisible = 0;
+	TArray<int32> VisiblePerRow;
+	VisiblePerRow.Reserve(PVSTable.GetNumRows());
+	for (int32 Row = 0; Row < PVSTable.GetNumRows(); ++Row)
+	{
+		NumRuns += PVSTable.GetNumRuns(Row);
+		VisiblePerRow.Add(PVSTable.GetNumVisibleCells(Row));
+		NumVisible += VisiblePerRow.Last();
+	}
+
+	const int32 NumRows = FMath::Max(PVSTable.GetNumRows(), 1);
+	GLog->Logf(TEXT("PVS table : %dx%d grid, %d cells%s, %s (%.1f bytes/cell), %.1f runs/row, %.1f visible cells/row"), PVSTable.GetNumX(), PVSTable.GetNumY(), NumCells,
+		PVSTable.IsHierarchical() ? *FString::Printf(TEXT(" in %dx%d blocks"), PVSTable.GetBlockSize(), PVSTable.GetBlockSize()) : TEXT(""), *BytesToString(PVSTable.GetAllocatedSize()),
+		NumCells > 0 ? (double)PVSTable.GetAllocatedSize() / NumCells : 0.0, (double)NumRuns / NumRows, (double)NumVisible / NumRows);
+
+	// GridCells. With shared gather lists they only hold dormant actors (and the overflow cell), so most cells never allocate one.
+	TArray<const UReplicationGraphNode_GridCell*> GridCells;
+	for (const UReplicationGraphNode_GridCell* GridCell : FlatGrid)
+	{
+		if (GridCell)
+		{
+			GridCells.Add(GridCell);
+		}
+	}
+	for (const TArray<UReplicationGraphNode_GridCell*>& GridX : Grid)
+	{
+		for (const UReplicationGraphNode_GridCell* GridCell : GridX)
+		{
+			if (GridCell)
+			{
+				GridCells.Add(GridCell);
+			}
+		}
+	}
+
+	int32 NumGridCellEntries = 0;
+	int32 MaxGridCellEntries = 0;
+	TArray<FActorRepListType> CellActors;
+	for (const UReplicationGraphNode_GridCell* GridCell : GridCells)
+	{
+		CellActors.Reset();
+		GridCell->GetAllActorsInNode_Debugging(CellActors);
+		NumGridCellEntries += CellActors.Num();
+		MaxGridCellEntries = FMath::Max(MaxGridCellEntries, CellActors.Num());
+	}
+
+	GLog->Logf(TEXT("PVS GridCells : %d allocated of %d (%s grid)%s, ~%s of nodes (%d bytes each), %d list entries (max %d in one cell)"), GridCells.Num(), NumCells,
+		bUseFlatGrid ? TEXT("flat") : TEXT("lazy"), OverflowCell ? TEXT(" + overflow") : TEXT(""), *BytesToString((GridCells.Num() + (OverflowCell ? 1 : 0)) * sizeof(UReplicationGraphNode_GridCell)),
+		(int32)sizeof(UReplicationGraphNode_GridCell), NumGridCellEntries, MaxGridCellEntries);
+
+	// Actor bookkeeping.
+	const SIZE_T DynamicSize = DynamicActors.Actors.GetAllocatedSize() + DynamicActors.RepInfos.GetAllocatedSize() + DynamicActors.Locations.GetAllocatedSize()
+		+ DynamicActors.Cells.GetAllocatedSize() + DynamicActors.NewCells.GetAllocatedSize() + DynamicActors.ActorInfos.GetAllocatedSize()
+		+ DynamicActors.MovementSources.GetAllocatedSize() + DynamicActors.Moved.GetAllocatedSize() + DynamicActorIndices.GetAllocatedSize();
+
+	GLog->Logf(TEXT("PVS actors : %d dynamic (%s, %d bytes/actor), %d static (%s), %d dormant cells"), DynamicActors.Num(), *BytesToString(DynamicSize),
+		DynamicActors.Num() > 0 ? (int32)(DynamicSize / DynamicActors.Num()) : 0, StaticSpatializedActors.Num(), *BytesToString(StaticSpatializedActors.GetAllocatedSize()), DormantCells.Num());
+
+	// Per connection and per viewer cell caches.
+	int32 NumSharedListActors = 0;
+	for (const auto& It : SharedViewerCellLists)
+	{
+		NumSharedListActors += It.Value->ActorList.Num() + It.Value->MidActorList.Num() + It.Value->FarActorList.Num() + It.Value->FastSharedActorList.Num();
+	}
+	int32 NumMultiViewerActors = 0;
+	for (const auto& It : MultiViewerLists)
+	{
+		NumMultiViewerActors += It.Value.ActorList.Num() + It.Value.FastSharedActorList.Num();
+	}
+	int32 NumAudibleActors = 0;
+	for (const auto& It : AudibleLists)
+	{
+		NumAudibleActors += It.Value.ActorList.Num();
+	}
+	int32 NumTierReducedActors = 0;
+	for (const auto& It : DistanceTierStates)
+	{
+		NumTierReducedActors += It.Value.ReducedActors.Num();
+	}
+	int32 NumPausedActors = 0;
+	for (const auto& It : PausedChannels)
+	{
+		NumPausedActors += It.Value.Actors.Num();
+	}
+
+	GLog->Logf(TEXT("PVS lists : %d shared viewer cell lists (%d entries), %d multi viewer (%d), %d audible (%d), %d tier states (%d reduced actors), %d paused (%d), occupancy %d dynamic + %d static entries"),
+		SharedViewerCellLists.Num(), NumSharedListActors, MultiViewerLists.Num(), NumMultiViewerActors, AudibleLists.Num(), NumAudibleActors, DistanceTierStates.Num(), NumTierReducedActors,
+		PausedChannels.Num(), NumPausedActors, OccupiedCells.Num(), StaticOccupiedCells.Num());
+	GLog->Logf(TEXT("PVS node heap total : %s"), *BytesToString(GetAllocatedSize()));
+
+	// Occupancy, from the actors' own cells so it is the same with or without shared gather lists.
+	TArray<int32> ActorsPerCell;
+	ActorsPerCell.SetNumZeroed(NumCells);
+	int32 NumOverflow = 0;
+	auto CountCell = [this, &ActorsPerCell, &NumOverflow](FNebulaCellId Cell)
+		{
+			if (Cell.IsOverflow())
+			{
+				++NumOverflow;
+			}
+			else if (Cell.IsValid())
+			{
+				++ActorsPerCell[PVSGrid.GetCellIndex(Cell)];
+			}
+		};
+
+	for (const FNebulaCellId Cell : DynamicActors.Cells)
+	{
+		CountCell(Cell);
+	}
+	for (const TPair<FActorRepListType, FCachedStaticActorInfo>& It : StaticSpatializedActors)
+	{
+		CountCell(It.Value.CellInfo.CellIndex);
+	}
+
+	const int32 NumPopulated = Algo::CountIf(ActorsPerCell, [](int32 Count) { return Count > 0; });
+	GLog->Logf(TEXT("PVS occupancy : %d of %d cells populated, %d actors in overflow"), NumPopulated, NumCells, NumOverflow);
+	PrintHistogram(TEXT("PVS actors per cell"), ActorsPerCell);
+	PrintHistogram(TEXT("PVS visible cells per row"), VisiblePerRow);
+}
+
+int32 UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GetTableCellIndex(const FVector& Location) const
+{
+	return PVSGrid.GetCellIndex(Location);
+}
+
+bool UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GetViewerCellIndex(const UNetConnection* NetConnection, int32& OutCellIndex) const
+{
+	FNebulaCellId Cell;
+	if (!GetViewerCell(NetConnection, Cell) || Cell.IsOverflow())
+	{
+		return false;
+	}
+
+	OutCellIndex = PVSTable.GetCellIndex(Cell.GetX(), Cell.GetY());
+	return true;
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::RebuildStaticOccupancy()
+{
+	bStaticOccupancyDirty = false;
+
+	StaticOccupiedCells.Reset();
+	DormantCells.Reset();
+
+	for (const auto& MapIt : StaticSpatializedActors)
+	{
+		const FActorCellInfo& CellInfo = MapIt.Value.CellInfo;
+		if (!PVSTable.IsValidCell(CellInfo.CellIndex.GetX(), CellInfo.CellIndex.GetY()))
+		{
+			continue;
+		}
+
+		const int32 CellIndex = PVSTable.GetCellIndex(CellInfo.CellIndex.GetX(), CellInfo.CellIndex.GetY());
+		if (MapIt.Value.bDormancyDriven)
+		{
+			DormantCells.Add(CellIndex);
+		}
+		else
+		{
+			StaticOccupiedCells.Add({ CellIndex, MapIt.Key });
+		}
+	}
+
+	Algo::SortBy(StaticOccupiedCells, &FOccupiedCellActor::CellIndex);
+	DormantCells.Sort();
+	DormantCells.SetNum(Algo::Unique(DormantCells), EAllowShrinking::No);
+}
+
+/**
+* Builds one list per cell that holds at least one viewer, merging the dynamic and static actors of every cell in its PVS row.
+* Each actor is in exactly one cell and each visible cell appears once in a row, so the merged list has no duplicates.
+* Connections in the same cell then share the list, so the cost scales with occupied viewer cells instead of connections x visible cells.
+*/
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::BuildSharedGatherLists()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_PVS_BuildSharedLists);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, PVS_BuildSharedLists);
+
+	++SharedListsFrame;
+
+	if (bStaticOccupancyDirty)
+	{
+		RebuildStaticOccupancy();
+	}
+
+	// Same frequency bucketing as GridCells : actors outside of this frame's bucket only get FastShared updates, if their class has a FastShared function.
+	const int32 NumBuckets = Nebula::RepGraph::EnableFastSharedPath > 0 ? FMath::Max(Nebula::RepGraph::DynamicActorFrequencyBuckets, 1) : 1;
+	const int32 CurrentBucket = SharedListsFrame % NumBuckets;
+
+	// Dynamic actors sorted by cell index, so each row can be merge-joined against them.
+	OccupiedCells.Reset();
+	for (int32 Index = 0; Index < DynamicActors.Num(); ++Index)
+	{
+		const FNebulaCellId Cell = DynamicActors.Cells[Index];
+		if (PVSTable.IsValidCell(Cell.GetX(), Cell.GetY()))
+		{
+			const bool bFastShared = NumBuckets > 1 && (Index % NumBuckets) != CurrentBucket && DynamicActors.RepInfos[Index]->Settings.FastSharedReplicationFunc;
+			OccupiedCells.Add({ PVSTable.GetCellIndex(Cell.GetX(), Cell.GetY()), DynamicActors.Actors[Index], bFastShared });
+		}
+	}
+	Algo::SortBy(OccupiedCells, &FOccupiedCellActor::CellIndex);
+
+	// Resolve viewer cells on the game thread : it reads the view targets' global info and adds map entries. Each occupied cell is queued once.
+	PendingSharedLists.Reset();
+	auto QueueSharedList = [this](int32 ViewerCellIndex)
+		{
+			TUniquePtr<FSharedViewerCellList>& SharedListPtr = SharedViewerCellLists.FindOrAdd(ViewerCellIndex);
+			if (!SharedListPtr.IsValid())
+			{
+				SharedListPtr = MakeUnique<FSharedViewerCellList>();
+			}
+
+			if (SharedListPtr->BuiltFrame != SharedListsFrame)
+			{
+				SharedListPtr->BuiltFrame = SharedListsFrame;
+				PendingSharedLists.Emplace(ViewerCellIndex, SharedListPtr.Get());
+			}
+		};
+
+	UNebulaReplicationGraph* NebulaGraph = CastChecked<UNebulaReplicationGraph>(GetOuter());
+	for (UNetReplicationGraphConnection* ConnManager : NebulaGraph->GetConnectionManagers())
+	{
+		int32 ViewerCellIndex = INDEX_NONE;
+		if (GetViewerCellIndex(ConnManager->NetConnection, ViewerCellIndex))
+		{
+			QueueSharedList(ViewerCellIndex);
+		}
+	}
+
+	for (const int32 ViewerCellIndex : SyntheticViewerCells)
+	{
+		QueueSharedList(ViewerCellIndex);
+	}
+
+	// Rows and lists of different cells are independent. The serial gather only hands the built lists to each connection.
+	const bool bParallel = Nebula::RepGraph::PVSParallelGather > 0 && PendingSharedLists.Num() >= Nebula::RepGraph::PVSParallelGatherMinCells;
+	ParallelFor(PendingSharedLists.Num(), [this](int32 Idx)
+		{
+			BuildSharedList(PendingSharedLists[Idx].Key, *PendingSharedLists[Idx].Value);
+		}, bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	// Drop lists of cells no viewer stood in this frame.
+	for (auto It = SharedViewerCellLists.CreateIterator(); It; ++It)
+	{
+		if (It.Value()->BuiltFrame != SharedListsFrame)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+const UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::FSharedViewerCellList& UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GetOrBuildSharedList(int32 ViewerCellIndex)
+{
+	TUniquePtr<FSharedViewerCellList>& SharedListPtr = SharedViewerCellLists.FindOrAdd(ViewerCellIndex);
+	if (!SharedListPtr.IsValid())
+	{
+		SharedListPtr = MakeUnique<FSharedViewerCellList>();
+	}
+
+	FSharedViewerCellList& SharedList = *SharedListPtr;
+	if (SharedList.BuiltFrame != SharedListsFrame)
+	{
+		SharedList.BuiltFrame = SharedListsFrame;
+		BuildSharedList(ViewerCellIndex, SharedList);
+	}
+
+	return SharedList;
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::BuildSharedList(int32 ViewerCellIndex, FSharedViewerCellList& SharedList) const
+{
+	SharedList.ActorList.Reset();
+	SharedList.MidActorList.Reset();
+	SharedList.FarActorList.Reset();
+	SharedList.FastSharedActorList.Reset();
+
+	// Distance tiers in grid cells, measured between cell centers. Every client standing in the viewer cell gets the same tiers, like the rest of the list.
+	const bool bUseTiers = Nebula::RepGraph::PVSTierMidDistance > 0.f && CellSize > 0.f;
+	const double MidDistSq = FMath::Square(Nebula::RepGraph::PVSTierMidDistance / CellSize);
+	const double FarDistSq = Nebula::RepGraph::PVSTierFarDistance > 0.f ? FMath::Square(Nebula::RepGraph::PVSTierFarDistance / CellSize) : UE_DOUBLE_BIG_NUMBER;
+	const FVector2D ViewerCenter = bUseTiers ? GetCellCenter(ViewerCellIndex) : FVector2D::ZeroVector;
+
+	int32 DynamicIdx = 0;
+	int32 StaticIdx = 0;
+	PVSTable.ForEachVisibleCell(ViewerCellIndex, [&](int32 VisibleCellIndex)
+		{
+			// Resolved on the first occupant, most visible cells are empty.
+			FActorRepListRefView* TierList = nullptr;
+			auto GetTierList = [&]() -> FActorRepListRefView&
+				{
+					if (TierList == nullptr)
+					{
+						const double DistSq = bUseTiers ? FVector2D::DistSquared(ViewerCenter, GetCellCenter(VisibleCellIndex)) : 0.0;
+						TierList = DistSq >= FarDistSq ? &SharedList.FarActorList : DistSq >= MidDistSq ? &SharedList.MidActorList : &SharedList.ActorList;
+					}
+					return *TierList;
+				};
+
+			auto MergeCell = [&SharedList, &GetTierList, VisibleCellIndex](const TArray<FOccupiedCellActor>& Occupied, int32& Idx)
+				{
+					while (Idx < Occupied.Num() && Occupied[Idx].CellIndex < VisibleCellIndex)
+					{
+						++Idx;
+					}
+
+					for (; Idx < Occupied.Num() && Occupied[Idx].CellIndex == VisibleCellIndex; ++Idx)
+					{
+						(Occupied[Idx].bFastShared ? SharedList.FastSharedActorList : GetTierList()).Add(Occupied[Idx].Actor);
+					}
+				};
+
+			MergeCell(OccupiedCells, DynamicIdx);
+			MergeCell(StaticOccupiedCells, StaticIdx);
+		});
+}
+
+FVector2D UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GetCellCenter(int32 CellIndex) const
+{
+	return PVSGrid.GetCellCenter(CellIndex);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::UpdateDistanceTierPeriods(const FConnectionGatherActorListParameters& Params, const FSharedViewerCellList* SharedList)
+{
+	const bool bHasTiers = SharedList && (SharedList->MidActorList.Num() > 0 || SharedList->FarActorList.Num() > 0);
+
+	FDistanceTierState* State = DistanceTierStates.Find(Params.ConnectionManager.NetConnection);
+	if (State == nullptr)
+	{
+		if (!bHasTiers)
+		{
+			return;
+		}
+		State = &DistanceTierStates.Add(Params.ConnectionManager.NetConnection);
+	}
+	State->BuiltFrame = Params.ReplicationFrameNum;
+
+	// Give last gather's actors their period back before reducing this gather's. Only tiered actors are ever touched, near ones cost nothing.
+	FPerConnectionActorInfoMap& ActorInfoMap = Params.ConnectionManager.ActorInfoMap;
+	for (const TPair<FActorRepListType, uint32>& It : State->ReducedActors)
+	{
+		if (FConnectionReplicationActorInfo* ConnectionActorInfo = ActorInfoMap.Find(It.Key))
+		{
+			ConnectionActorInfo->ReplicationPeriodFrame = It.Value;
+		}
+	}
+	State->ReducedActors.Reset();
+
+	if (!bHasTiers)
+	{
+		DistanceTierStates.Remove(Params.ConnectionManager.NetConnection);
+		return;
+	}
+
+	// The replication loop skips an actor until ReplicationPeriodFrame frames after its last update, which keeps far actors staggered instead of bursting on one frame.
+	auto ReducePeriod = [&ActorInfoMap, State](const FActorRepListRefView& List, int32 Period)
+		{
+			for (FActorRepListType Actor : List)
+			{
+				FConnectionReplicationActorInfo& ConnectionActorInfo = ActorInfoMap.FindOrAdd(Actor);
+				State->ReducedActors.Emplace(Actor, ConnectionActorInfo.ReplicationPeriodFrame);
+				ConnectionActorInfo.ReplicationPeriodFrame = FMath::Max<uint32>(ConnectionActorInfo.ReplicationPeriodFrame, (uint32)FMath::Max(Period, 1));
+			}
+		};
+
+	ReducePeriod(SharedList->MidActorList, Nebula::RepGraph::PVSTierMidReplicationPeriod);
+	ReducePeriod(SharedList->FarActorList, Nebula::RepGraph::PVSTierFarReplicationPeriod);
+	NEBULA_REPGRAPH_COUNT(PVSTierReducedActors, State->ReducedActors.Num());
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::KeepPausedChannelsOpen(const FConnectionGatherActorListParameters& Params, const FViewerVisibility& Visibility, TConstArrayView<int32> ViewerCellIndices)
+{
+	const uint32 PauseFrames = (uint32)FMath::Max(Nebula::RepGraph::PVSPauseFrames, 0);
+	if (PauseFrames == 0)
+	{
+		PausedChannels.Remove(Params.ConnectionManager.NetConnection);
+		return;
+	}
+
+	const uint32 FrameNum = Params.ReplicationFrameNum;
+	FPausedChannels& State = PausedChannels.FindOrAdd(Params.ConnectionManager.NetConnection);
+
+	// Visible from the viewer cells of the last gather.
+	auto WasVisible = [this, &State](int32 CellIndex)
+		{
+			return CellIndex != INDEX_NONE && Algo::AnyOf(State.ViewerCellIndices, [this, CellIndex](int32 ViewerCellIndex) { return PVSTable.IsVisible(ViewerCellIndex, CellIndex); });
+		};
+
+	auto IsHidden = [&Visibility](int32 CellIndex)
+		{
+			return CellIndex != INDEX_NONE && !Visibility.IsVisible(CellIndex);
+		};
+
+	// A viewer changed cell, or this connection skipped a gather and missed some cell changes : diff the whole old row against the new one.
+	if (State.ViewerCellIndices.Num() > 0 && (State.BuiltFrame + 1 != FrameNum || !Algo::Compare(State.ViewerCellIndices, ViewerCellIndices)))
+	{
+		for (int32 Index = 0; Index < DynamicActors.Num(); ++Index)
+		{
+			const int32 CellIndex = PVSGrid.GetCellIndex(DynamicActors.Cells[Index]);
+			if (WasVisible(CellIndex) && IsHidden(CellIndex))
+			{
+				State.Actors.AddUnique(DynamicActors.Actors[Index]);
+			}
+		}
+	}
+
+	for (const TPair<FActorRepListType, FNebulaCellId>& Change : DynamicCellChanges)
+	{
+		const int32* Index = DynamicActorIndices.Find(Change.Key);
+		if (Index && WasVisible(PVSGrid.GetCellIndex(Change.Value)) && IsHidden(PVSGrid.GetCellIndex(DynamicActors.Cells[*Index])))
+		{
+			State.Actors.AddUnique(Change.Key);
+		}
+	}
+
+	State.ViewerCellIndices.Reset();
+	State.ViewerCellIndices.Append(ViewerCellIndices.GetData(), ViewerCellIndices.Num());
+	State.BuiltFrame = FrameNum;
+
+	// An actor that stopped being gathered stops replicating, so LastRepFrameNum is when it left the visible cells (or went idle).
+	// Pushing the channel close frame forward keeps it open without sending anything : the client keeps the actor frozen instead of destroying it.
+	for (int32 PausedIndex = State.Actors.Num() - 1; PausedIndex >= 0; --PausedIndex)
+	{
+		const FActorRepListType Actor = State.Actors[PausedIndex];
+		const int32* Index = DynamicActorIndices.Find(Actor);
+		FConnectionReplicationActorInfo* ConnectionActorInfo = Index && IsHidden(PVSGrid.GetCellIndex(DynamicActors.Cells[*Index])) ? Params.ConnectionManager.ActorInfoMap.Find(Actor) : nullptr;
+
+		if (ConnectionActorInfo && ConnectionActorInfo->Channel && FrameNum - (uint32)ConnectionActorInfo->LastRepFrameNum <= PauseFrames)
+		{
+			ConnectionActorInfo->ActorChannelCloseFrameNum = FMath::Max<uint32>(ConnectionActorInfo->ActorChannelCloseFrameNum, FrameNum + 2);
+		}
+		else
+		{
+			// Visible again, past the pause or gone.
+			State.Actors.RemoveAtSwap(PausedIndex, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+/**
+* 1) Get ViewTarget's Grid index from WorldLocation (imagine First Person, but use ViewLocation in Params.Viewers if Third Person)
+* 2) Find visible GridCells from LookupTable
+* 3) Gather by iterating visible GridCells
+*/
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_PVS_Gather);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, PVS_Gather);
+
+	const int32 NumListsBefore = Params.OutGatheredReplicationLists.NumLists();
+	ON_SCOPE_EXIT
+	{
+		NEBULA_REPGRAPH_COUNT(PVSListsEmitted, Params.OutGatheredReplicationLists.NumLists() - NumListsBefore);
+	};
+
+	// Only set for a single viewer cell in shared gather list mode. Team and multi-viewer lists aren't tiered, so any other path restores what the last gather raised.
+	const FSharedViewerCellList* TieredSharedList = nullptr;
+	ON_SCOPE_EXIT
+	{
+		UpdateDistanceTierPeriods(Params, TieredSharedList);
+	};
+
+	// Every viewer of the connection (split-screen children, spectator cams) from its view point. Usually all of them share one cell.
+	TArray<int32, TInlineAllocator<4>> ViewerCellIndices;
+	TArray<FVector, TInlineAllocator<4>> ViewerLocations;
+	bool bAnyViewerInOverflow = false;
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		const FNebulaCellId ViewerCell = GetCellForLocation(Viewer.ViewLocation);
+		if (ViewerCell.IsOverflow())
+		{
+			bAnyViewerInOverflow = true;
+			continue;
+		}
+
+		ViewerCellIndices.AddUnique(PVSTable.GetCellIndex(ViewerCell.GetX(), ViewerCell.GetY()));
+		ViewerLocations.Add(Viewer.ViewLocation);
+	}
+
+	if (bAnyViewerInOverflow && OverflowCell)
+	{
+		OverflowCell->GatherActorListsForConnection(Params);
+	}
+
+	if (ViewerCellIndices.Num() == 0)
+	{
+		return;
+	}
+
+	FViewerVisibility Visibility;
+	Visibility.Table = &PVSTable;
+	Visibility.CellIndex = ViewerCellIndices[0];
+
+	// Several cells : OR the rows once, then gather the union, so a cell seen by two viewers is only gathered once.
+	if (ViewerCellIndices.Num() > 1)
+	{
+		ViewerUnionCells.Init(false, PVSTable.GetNumCells());
+		for (const int32 CellIndex : ViewerCellIndices)
+		{
+			PVSTable.ForEachVisibleCell(CellIndex, [this](int32 VisibleCellIndex) { ViewerUnionCells[VisibleCellIndex] = true; });
+		}
+		Visibility.UnionCells = &ViewerUnionCells;
+	}
+
+#if STATS || CSV_PROFILER
+	NEBULA_REPGRAPH_COUNT(PVSCellsGathered, Visibility.UnionCells ? Visibility.UnionCells->CountSetBits() : PVSTable.GetNumVisibleCells(Visibility.CellIndex));
+	for (const int32 CellIndex : ViewerCellIndices)
+	{
+		NEBULA_REPGRAPH_COUNT(PVSRowRuns, PVSTable.GetNumRuns(CellIndex));
+	}
+#endif
+
+	GatherAudibleActors(Params, Visibility, ViewerLocations);
+	KeepPausedChannelsOpen(Params, Visibility, ViewerCellIndices);
+
+	// Teammates share vision : UNebulaReplicationGraphNode_PVSTeamVision gathers the union of the team's rows instead.
+	const UNebulaReplicationGraph* NebulaGraph = CastChecked<UNebulaReplicationGraph>(GraphGlobals->ReplicationGraph);
+	if (NebulaGraph->PVSTeamNode && NebulaGraph->PVSTeamNode->IsTeamConnection(Params.ConnectionManager.NetConnection))
+	{
+		return;
+	}
+
+	if (Visibility.UnionCells)
+	{
+		if (bUseSharedGatherLists)
+		{
+			FMultiViewerList& MultiViewerList = MultiViewerLists.FindOrAdd(Params.ConnectionManager.NetConnection);
+			MultiViewerList.BuiltFrame = Params.ReplicationFrameNum;
+			BuildListFromCells(ViewerUnionCells, MultiViewerList.ActorList, MultiViewerList.FastSharedActorList);
+
+			if (MultiViewerList.ActorList.Num() > 0)
+			{
+				Params.OutGatheredReplicationLists.AddReplicationActorList(MultiViewerList.ActorList);
+			}
+			if (MultiViewerList.FastSharedActorList.Num() > 0)
+			{
+				Params.OutGatheredReplicationLists.AddReplicationActorList(MultiViewerList.FastSharedActorList, EActorRepListTypeFlags::FastShared);
+			}
+		}
+
+		GatherGridCells(Params, ViewerUnionCells, bUseSharedGatherLists);
+		return;
+	}
+
+	const int32 ViewerCellIndex = Visibility.CellIndex;
+	if (bUseSharedGatherLists)
+	{
+		// Normally built in PrepareForReplication. Built here if the viewer moved into a cell nobody stood in at prepare time.
+		const FSharedViewerCellList& SharedList = GetOrBuildSharedList(ViewerCellIndex);
+		if (SharedList.ActorList.Num() > 0)
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(SharedList.ActorList);
+		}
+		if (SharedList.MidActorList.Num() > 0)
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(SharedList.MidActorList);
+		}
+		if (SharedList.FarActorList.Num() > 0)
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(SharedList.FarActorList);
+		}
+		TieredSharedList = &SharedList;
+		if (SharedList.FastSharedActorList.Num() > 0)
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(SharedList.FastSharedActorList, EActorRepListTypeFlags::FastShared);
+		}
+
+		// Dormant actors still come from their GridCells, which handle dormancy per connection. Only dormant actors live in GridCells in this mode.
+		int32 DormantIdx = 0;
+		PVSTable.ForEachVisibleCell(ViewerCellIndex, [this, &Params, &DormantIdx](int32 VisibleCellIndex)
+			{
+				while (DormantIdx < DormantCells.Num() && DormantCells[DormantIdx] < VisibleCellIndex)
+				{
+					++DormantIdx;
+				}
+
+				if (DormantIdx < DormantCells.Num() && DormantCells[DormantIdx] == VisibleCellIndex)
+				{
+					if (UReplicationGraphNode_GridCell* GridCell = FindCell(VisibleCellIndex))
+					{
+						GridCell->GatherActorListsForConnection(Params);
+					}
+				}
+			});
+		return;
+	}
+
+	PVSTable.ForEachVisibleCell(ViewerCellIndex, [this, &Params](int32 VisibleCellIndex)
+		{
+			// Never create cells here : a visible cell nobody has entered yet has nothing to gather.
+			if (UReplicationGraphNode_GridCell* GridCell = FindCell(VisibleCellIndex))
+			{
+				GridCell->GatherActorListsForConnection(Params);
+			}
+		});
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::BuildListFromCells(const TBitArray<>& Cells, FActorRepListRefView& OutList, FActorRepListRefView& OutFastSharedList) const
+{
+	OutList.Reset();
+	OutFastSharedList.Reset();
+
+	auto AddOccupants = [&](const TArray<FOccupiedCellActor>& Occupied)
+		{
+			for (const FOccupiedCellActor& Occupant : Occupied)
+			{
+				if (Cells[Occupant.CellIndex])
+				{
+					(Occupant.bFastShared ? OutFastSharedList : OutList).Add(Occupant.Actor);
+				}
+			}
+		};
+
+	AddOccupants(OccupiedCells);
+	AddOccupants(StaticOccupiedCells);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GatherGridCells(const FConnectionGatherActorListParameters& Params, const TBitArray<>& Cells, bool bDormantOnly) const
+{
+	auto GatherCell = [this, &Params](int32 CellIndex)
+		{
+			if (UReplicationGraphNode_GridCell* GridCell = FindCell(CellIndex))
+			{
+				GridCell->GatherActorListsForConnection(Params);
+			}
+		};
+
+	if (bDormantOnly)
+	{
+		for (const int32 DormantCellIndex : DormantCells)
+		{
+			if (Cells[DormantCellIndex])
+			{
+				GatherCell(DormantCellIndex);
+			}
+		}
+		return;
+	}
+
+	for (TConstSetBitIterator<> It(Cells); It; ++It)
+	{
+		GatherCell(It.GetIndex());
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::AddActorInternal_Dynamic(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo)
+{
+	if (UNLIKELY(Nebula::RepGraph::PVSLogCellChanges > 0))
+	{
+		UE_LOG(LogNebulaRepGraph, Verbose, TEXT("Dynamic Actor : %s is Added in PrecomputedVisibilityGrid2D Node."), *ActorInfo.Actor->GetName());
+	}
+
+	const int32 Index = DynamicActors.Add(ActorInfo, &ActorRepInfo);
+	DynamicActorIndices.Add(ActorInfo.Actor, Index);
+	bAudibleOccupancyDirty = true;
+
+	if (bUseEventDrivenUpdates)
+	{
+		// Bucket it on the next frame, then only again once it moves.
+		DynamicActors.Moved[Index] = true;
+		MovedDynamicActors.Add(ActorInfo.Actor);
+
+		if (USceneComponent* RootComponent = ActorInfo.Actor->GetRootComponent())
+		{
+			DynamicActors.MovementSources[Index] = RootComponent;
+			RootComponent->TransformUpdated.AddUObject(this, &UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::OnDynamicActorTransformUpdated);
+		}
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::AddActorInternal_Static(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo, bool bDormancyDriven)
+{
+	AActor* Actor = ActorInfo.Actor;
+
+	// Static actors don't move, so this is the only time their location is read.
+	ActorRepInfo.WorldLocation = Actor->GetActorLocation();
+
+	FCachedStaticActorInfo& StaticActorInfo = StaticSpatializedActors.Emplace(Actor, FCachedStaticActorInfo(ActorInfo, bDormancyDriven));
+	StaticActorInfo.CellInfo.CellIndex = GetCellForLocation(ActorRepInfo.WorldLocation);
+
+	const FNebulaCellId Cell = StaticActorInfo.CellInfo.CellIndex;
+	if (bDormancyDriven || LivesInGridCell(Cell))
+	{
+		if (UReplicationGraphNode_GridCell* GridCell = GetCellNode(GetCell(Cell)))
+		{
+			GridCell->AddStaticActor(ActorInfo, ActorRepInfo, bDormancyDriven);
+		}
+	}
+
+	bStaticOccupancyDirty = true;
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::RemoveActorInternal_Dynamic(const FNewReplicatedActorInfo& ActorInfo)
+{
+	int32 Index = INDEX_NONE;
+	if (DynamicActorIndices.RemoveAndCopyValue(ActorInfo.Actor, Index))
+	{
+		const FNebulaCellId Cell = DynamicActors.Cells[Index];
+		if (Cell.IsValid() && LivesInGridCell(Cell))
+		{
+			if (UReplicationGraphNode_GridCell* GridCell = FindCell(Cell))
+			{
+				GridCell->RemoveDynamicActor(ActorInfo);
+			}
+		}
+
+		if (USceneComponent* MovementSource = DynamicActors.MovementSources[Index].Get())
+		{
+			MovementSource->TransformUpdated.RemoveAll(this);
+		}
+
+		DynamicActors.RemoveAtSwap(Index);
+		bAudibleOccupancyDirty = true;
+
+		ForgetActor(ActorInfo.Actor);
+
+		// Fix up the handle of the actor swapped into the hole.
+		if (Index < DynamicActors.Num())
+		{
+			DynamicActorIndices.FindChecked(DynamicActors.Actors[Index]) = Index;
+		}
+	}
+	if (UNLIKELY(Nebula::RepGraph::PVSLogCellChanges > 0))
+	{
+		UE_LOG(LogNebulaRepGraph, Verbose, TEXT("Dynamic Actor : %s is Removed in PrecomputedVisibilityGrid2D Node."), *ActorInfo.Actor->GetName());
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::RemoveActorInternal_Static(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (FCachedStaticActorInfo* StaticActorInfo = StaticSpatializedActors.Find(ActorInfo.Actor))
+	{
+		const FNebulaCellId Cell = StaticActorInfo->CellInfo.CellIndex;
+		if (StaticActorInfo->bDormancyDriven || LivesInGridCell(Cell))
+		{
+			if (UReplicationGraphNode_GridCell* GridCell = FindCell(Cell))
+			{
+				FGlobalActorReplicationInfo& ActorRepInfo = GraphGlobals->GlobalActorReplicationInfoMap->Get(ActorInfo.Actor);
+				GridCell->RemoveStaticActor(ActorInfo, ActorRepInfo, StaticActorInfo->bDormancyDriven);
+			}
+		}
+
+		StaticSpatializedActors.Remove(ActorInfo.Actor);
+		bStaticOccupancyDirty = true;
+		ForgetActor(ActorInfo.Actor);
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::ForgetActor(FActorRepListType Actor)
+{
+	// Don't keep the pointer around for a later actor allocated at the same address.
+	DynamicCellChanges.RemoveAllSwap([Actor](const TPair<FActorRepListType, FNebulaCellId>& Change) { return Change.Key == Actor; });
+	for (auto& It : PausedChannels)
+	{
+		It.Value.Actors.RemoveSwap(Actor);
+	}
+
+	// Give the period back first : RebucketAllActors adds the actor again, and the next gather would no longer know it was raised.
+	for (auto& It : DistanceTierStates)
+	{
+		TArray<TPair<FActorRepListType, uint32>>& ReducedActors = It.Value.ReducedActors;
+		const int32 ReducedIndex = ReducedActors.IndexOfByPredicate([Actor](const TPair<FActorRepListType, uint32>& Reduced) { return Reduced.Key == Actor; });
+		if (ReducedIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		UNetConnection* NetConnection = It.Key.ResolveObjectPtr();
+		if (UNetReplicationGraphConnection* ConnectionManager = NetConnection ? Cast<UNetReplicationGraphConnection>(NetConnection->GetReplicationConnectionDriver()) : nullptr)
+		{
+			if (FConnectionReplicationActorInfo* ConnectionActorInfo = ConnectionManager->ActorInfoMap.Find(Actor))
+			{
+				ConnectionActorInfo->ReplicationPeriodFrame = ReducedActors[ReducedIndex].Value;
+			}
+		}
+
+		ReducedActors.RemoveAtSwap(ReducedIndex, 1, EAllowShrinking::No);
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::AddActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo)
+{
+	if (ActorRepInfo.bWantsToBeDormant)
+	{
+		AddActorInternal_Static(ActorInfo, ActorRepInfo, true);
+	}
+	else
+	{
+		AddActorInternal_Dynamic(ActorInfo, ActorRepInfo);
+	}
+
+	// Tell us if dormancy changes for this actor because then we need to move it.
+	ActorRepInfo.Events.DormancyChange.AddUObject(this, &UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::OnNetDormancyChange);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::RemoveActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo)
+{
+	FGlobalActorReplicationInfo& ActorRepInfo = GraphGlobals->GlobalActorReplicationInfoMap->Get(ActorInfo.Actor);
+	if (ActorRepInfo.bWantsToBeDormant)
+	{
+		RemoveActorInternal_Static(ActorInfo);
+	}
+	else
+	{
+		RemoveActorInternal_Dynamic(ActorInfo);
+	}
+
+	ActorRepInfo.Events.DormancyChange.RemoveAll(this);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::OnNetDormancyChange(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo, ENetDormancy NewValue, ENetDormancy OldValue)
+{
+	const bool bCurrentShouldBeStatic = NewValue > DORM_Awake;
+	const bool bPreviousShouldBeStatic = OldValue > DORM_Awake;
+
+	if (bCurrentShouldBeStatic && !bPreviousShouldBeStatic)
+	{
+		// Actor was dynamic and is now static. Remove from dynamic list and add to static.
+		FNewReplicatedActorInfo ActorInfo(Actor);
+		RemoveActorInternal_Dynamic(ActorInfo);
+		AddActorInternal_Static(ActorInfo, GlobalInfo, true);
+	}
+	else if (!bCurrentShouldBeStatic && bPreviousShouldBeStatic)
+	{
+		FNewReplicatedActorInfo ActorInfo(Actor);
+		RemoveActorInternal_Static(ActorInfo);
+		AddActorInternal_Dynamic(ActorInfo, GlobalInfo);
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::InitLookupTable(const UNebulaPVSDataAsset* PVSData)
+{
+	// A reload started for the previous world must not be applied on top of this one.
+	if (PendingLookupTable.IsValid())
+	{
+		PendingLookupTable.Wait();
+		PendingLookupTable.Reset();
+		PendingPVSData = nullptr;
+	}
+
+	// InitGlobalGraphNodes and InitializeForWorld both load the table of the same world.
+	if (bLookupTableLoaded && LoadedPVSData.Get() == PVSData)
+	{
+		return;
+	}
+
+	bLookupTableLoaded = true;
+	LoadedPVSData = PVSData;
+
+	FNebulaPVSTable NewTable;
+	if (PVSData == nullptr || !PVSData->IsBaked() || !PVSData->Table.IsConsistent())
+	{
+		UE_LOG(LogNebulaRepGraph, Warning, TEXT("No baked PVS data for this map, falling back to the placeholder lookup table. See Nebula.PVS.Bake."));
+		LoadedPVSData = nullptr;
+		GenerateLookupTable(NewTable);
+		SetLookupTable(MoveTemp(NewTable), CellSize, SpatialBias);
+		return;
+	}
+
+	// Cell layout must match the layout the table was baked with.
+	if (CellSize != PVSData->CellSize || SpatialBias != PVSData->SpatialBias)
+	{
+		UE_LOG(LogNebulaRepGraph, Display, TEXT("PVS data %s overrides CellSize %.1f -> %.1f, SpatialBias %s -> %s"),
+			*PVSData->GetName(), CellSize, PVSData->CellSize, *SpatialBias.ToString(), *PVSData->SpatialBias.ToString());
+	}
+
+	NewTable = PVSData->Table;
+	SetLookupTable(MoveTemp(NewTable), PVSData->CellSize, PVSData->SpatialBias);
+
+	UE_LOG(LogNebulaRepGraph, Display, TEXT("PVS table loaded from %s : %dx%d grid, %d cells, %llu bytes"), *PVSData->GetName(), PVSTable.GetNumX(), PVSTable.GetNumY(), PVSTable.GetNumCells(), (uint64)PVSTable.GetAllocatedSize());
+}
+
+bool UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::SetLookupTable(FNebulaPVSTable&& NewTable, float NewCellSize, const FVector2D& NewSpatialBias)
+{
+	// Same layout : cells, their actors and the occupancy stay valid as they are. Shared and per connection lists are built from the rows each frame anyway.
+	if (PVSGrid.IsInitialized() && CellSize == NewCellSize && SpatialBias == NewSpatialBias && NewTable.HasSameLayout(PVSTable))
+	{
+		PVSTable = MoveTemp(NewTable);
+		return true;
+	}
+
+	if (DynamicActors.Num() > 0 || StaticSpatializedActors.Num() > 0)
+	{
+		RebucketAllActors(MoveTemp(NewTable), NewCellSize, NewSpatialBias);
+		return false;
+	}
+
+	PVSTable = MoveTemp(NewTable);
+	CellSize = NewCellSize;
+	SpatialBias = NewSpatialBias;
+	InitGrid();
+	return false;
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::GenerateLookupTable(FNebulaPVSTable& OutTable) const
+{
+	// ------------------------------------
+	// TestCase
+	// SpatialBias = -600, CellSize : 200
+	// ------------------------------------
+	const int32 NumX = (-SpatialBias.X * 2 / CellSize) + 1;
+	const int32 NumY = (-SpatialBias.Y * 2 / CellSize) + 1;
+	OutTable.Init(NumX, NumY);
+
+	// --------------------------------
+	//	grid cells brief specification
+	//					  (6, 6)
+	//		□□□□□□■
+	//		□□□□□□□
+	//		□□□□□□□
+	//		□□□□□□□
+	//		□□□□□□□
+	//		□□□□□□□
+	//		■□□□□□□
+	// (0,0)
+	// --------------------------------
+
+	// ---------------------------------------------------------------------------------
+	// | Placeholder only : every cell can see ({0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}) |
+	// | Real visibility comes from a baked UNebulaPVSDataAsset.                       |
+	// ---------------------------------------------------------------------------------
+	TArray<int32> PlaceholderVisibleCells;
+	for (int32 Y = 0; Y < FMath::Min(5, NumY); ++Y)
+	{
+		PlaceholderVisibleCells.Add(OutTable.GetCellIndex(0, Y));
+	}
+
+	for (int32 CellIndex = 0; CellIndex < OutTable.GetNumCells(); ++CellIndex)
+	{
+		OutTable.AppendRow(PlaceholderVisibleCells);
+	}
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::InitGrid()
+{
+	// Anything outside of the table goes to OverflowCell. The table is baked for a fixed bias, so growing the grid would only add cells without visibility info.
+	PVSGrid.Init(PVSTable, SpatialBias, CellSize);
+
+	// Cells of two-level tables aren't addressable by grid coordinate alone, they always use the flat grid.
+	bUseFlatGrid = (Nebula::RepGraph::PVSPreallocateGrid > 0 || PVSTable.IsHierarchical()) && PVSTable.GetNumCells() > 0;
+
+	// Latched here since it decides which actors live in GridCells.
+	bUseSharedGatherLists = Nebula::RepGraph::PVSSharedGatherLists > 0;
+
+	// Latched here since movement listeners are bound when dynamic actors are added.
+	bUseEventDrivenUpdates = Nebula::RepGraph::PVSEventDrivenUpdates > 0;
+	SharedViewerCellLists.Reset();
+	bStaticOccupancyDirty = true;
+
+	// Viewer cell indices of another layout.
+	PausedChannels.Reset();
+	DynamicCellChanges.Reset();
+	bAudibleOccupancyDirty = true;
+
+	FlatGrid.Reset();
+	if (bUseFlatGrid)
+	{
+		// Size the grid once from the table bounds, so PrepareForReplication and Gather never reallocate it.
+		FlatGrid.SetNumZeroed(PVSTable.GetNumCells());
+	}
+}
+
+bool UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::ReloadLookupTable(const UNebulaPVSDataAsset* PVSData)
+{
+	check(PVSData);
+
+	if (PendingLookupTable.IsValid())
+	{
+		return false;
+	}
+
+	PendingPVSData = PVSData;
+
+	// In editor, Nebula.PVS.Bake rewrites the asset's table in place, so the worker can't read it. Copy it here, the copy is a few flat arrays.
+	// Checking every row of a large table takes longer than a frame can spare, that part runs on the worker.
+	const FIntPoint GridSize = PVSData->GridSize;
+	TSharedPtr<FNebulaPVSTable> TableCopy = MakeShared<FNebulaPVSTable>(PVSData->Table);
+	PendingLookupTable = Async(EAsyncExecution::ThreadPool, [NewTable = MoveTemp(TableCopy), GridSize]() -> TSharedPtr<FNebulaPVSTable>
+		{
+			if (NewTable->GetNumX() != GridSize.X || NewTable->GetNumY() != GridSize.Y || !NewTable->IsConsistent())
+			{
+				return nullptr;
+			}
+			return NewTable;
+		});
+
+	return true;
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::ApplyPendingLookupTable()
+{
+	TSharedPtr<FNebulaPVSTable> NewTable = PendingLookupTable.Get();
+	PendingLookupTable.Reset();
+
+	const UNebulaPVSDataAsset* PVSData = PendingPVSData;
+	PendingPVSData = nullptr;
+
+	if (!NewTable.IsValid() || PVSData == nullptr)
+	{
+		UE_LOG(LogNebulaRepGraph, Error, TEXT("PVS reload of %s failed : table is not baked or is corrupt. Keeping the current table."), PVSData ? *PVSData->GetName() : TEXT("None"));
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const bool bSameLayout = SetLookupTable(MoveTemp(*NewTable), PVSData->CellSize, PVSData->SpatialBias);
+	LoadedPVSData = PVSData;
+
+	UE_LOG(LogNebulaRepGraph, Display, TEXT("PVS table reloaded from %s : %dx%d cells, %llu bytes, %s in %.2f ms"), *PVSData->GetName(), PVSTable.GetNumX(), PVSTable.GetNumY(),
+		(uint64)PVSTable.GetAllocatedSize(), bSameLayout ? TEXT("cells kept") : TEXT("actors re-bucketed"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::RebucketAllActors(FNebulaPVSTable&& NewTable, float NewCellSize, const FVector2D& NewSpatialBias)
+{
+	const TArray<FNewReplicatedActorInfo> DynamicActorInfos = DynamicActors.ActorInfos;
+
+	TArray<TPair<FNewReplicatedActorInfo, bool>> StaticActorInfos;
+	StaticActorInfos.Reserve(StaticSpatializedActors.Num());
+	for (const TPair<FActorRepListType, FCachedStaticActorInfo>& It : StaticSpatializedActors)
+	{
+		StaticActorInfos.Emplace(It.Value.ActorInfo, It.Value.bDormancyDriven);
+	}
+
+	// Removed with the old mapping, while FindCell still resolves their cells.
+	for (const FNewReplicatedActorInfo& ActorInfo : DynamicActorInfos)
+	{
+		RemoveActorInternal_Dynamic(ActorInfo);
+	}
+	for (const TPair<FNewReplicatedActorInfo, bool>& It : StaticActorInfos)
+	{
+		RemoveActorInternal_Static(It.Key);
+	}
+	MovedDynamicActors.Reset();
+
+	// The old cells don't map to anything anymore.
+	for (UReplicationGraphNode* ChildNode : AllChildNodes)
+	{
+		ChildNode->TearDown();
+	}
+	AllChildNodes.Reset();
+	Grid.Reset();
+	OverflowCell = nullptr;
+
+	PVSTable = MoveTemp(NewTable);
+	CellSize = NewCellSize;
+	SpatialBias = NewSpatialBias;
+	InitGrid();
+
+	FGlobalActorReplicationInfoMap* GlobalActorReplicationInfoMap = GraphGlobals->GlobalActorReplicationInfoMap;
+	for (const FNewReplicatedActorInfo& ActorInfo : DynamicActorInfos)
+	{
+		AddActorInternal_Dynamic(ActorInfo, GlobalActorReplicationInfoMap->Get(ActorInfo.Actor));
+	}
+	for (const TPair<FNewReplicatedActorInfo, bool>& It : StaticActorInfos)
+	{
+		AddActorInternal_Static(It.Key, GlobalActorReplicationInfoMap->Get(It.Key.Actor), It.Value);
+	}
+}
+
+FAutoConsoleCommandWithWorldAndArgs NebulaRepGraphReloadPVSCmd(TEXT("Nebula.RepGraph.ReloadPVS"), TEXT("Swaps in the baked PVS table of the current world without restarting the server. Usage: Nebula.RepGraph.ReloadPVS [AssetPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+			UNebulaReplicationGraph* Graph = NetDriver ? Cast<UNebulaReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+			UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D* Node = Graph ? Graph->PVSGridNode.Get() : nullptr;
+			UNebulaPVSNetObjectFilter* PVSFilter = UNebulaPVSNetObjectFilter::FindForWorld(World);
+			if (Node == nullptr && PVSFilter == nullptr)
+			{
+				UE_LOG(LogNebulaRepGraph, Error, TEXT("Nebula.RepGraph.ReloadPVS - needs a server world running UNebulaReplicationGraph or the Iris PVS filter."));
+				return;
+			}
+
+			// In editor, Nebula.PVS.Bake updates the loaded asset in place, so bake then reload to try out a new table on a running PIE server.
+			UNebulaPVSDataAsset* PVSData = nullptr;
+			if (Args.IsValidIndex(0))
+			{
+				PVSData = LoadObject<UNebulaPVSDataAsset>(nullptr, *Args[0]);
+			}
+			else
+			{
+				PVSData = UNebulaPVSDataAsset::FindForWorld(World);
+			}
+
+			if (PVSData == nullptr)
+			{
+				UE_LOG(LogNebulaRepGraph, Error, TEXT("Nebula.RepGraph.ReloadPVS - No PVS asset found. Pass an asset path or add the map to PVSDataPerMap."));
+				return;
+			}
+
+			// The filter copies the table right away, Iris has no frame budget to keep here.
+			if (PVSFilter)
+			{
+				PVSFilter->SetPVSData(PVSData);
+			}
+
+			if (Node && !Node->ReloadLookupTable(PVSData))
+			{
+				UE_LOG(LogNebulaRepGraph, Warning, TEXT("Nebula.RepGraph.ReloadPVS - a reload is already in progress."));
+			}
+		}));
+
+FAutoConsoleCommandWithWorldAndArgs NebulaRepGraphMemoryReportCmd(TEXT("Nebula.RepGraph.MemoryReport"), TEXT("Prints the memory use and cell occupancy of the Nebula replication graph running in this world."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+			if (const UNebulaReplicationGraph* Graph = NetDriver ? Cast<UNebulaReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr)
+			{
+				Graph->PrintMemoryReport();
+			}
+			else if (const UNebulaPVSNetObjectFilter* PVSFilter = UNebulaPVSNetObjectFilter::FindForWorld(World))
+			{
+				GLog->Logf(TEXT("Iris PVS filter : %d cells, %llu bytes"), PVSFilter->GetPVSGrid().IsInitialized() ? PVSFilter->GetPVSGrid().GetTable().GetNumCells() : 0, (uint64)PVSFilter->GetAllocatedSize());
+			}
+			else
+			{
+				UE_LOG(LogNebulaRepGraph, Error, TEXT("Nebula.RepGraph.MemoryReport - needs a server world running UNebulaReplicationGraph or the Iris PVS filter."));
+			}
+		}));
+
+// ------------------------------------------------------------------------------
+
+UNebulaReplicationGraphNode_PVSTeamVision::UNebulaReplicationGraphNode_PVSTeamVision()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UNebulaReplicationGraphNode_PVSTeamVision::PrepareForReplication()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_PVS_TeamVision);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, PVS_TeamVision);
+
+	// Drop teams that had no members last frame, before any index is handed out.
+	Teams.RemoveAllSwap([](const FTeamVision& Team) { return Team.NumMembers == 0; });
+	ConnectionTeams.Reset();
+
+	const FNebulaPVSTable& Table = PVSNode->GetPVSTable();
+	const int32 NumCells = Table.GetNumCells();
+	if (Nebula::RepGraph::PVSTeamVision <= 0 || NumCells == 0)
+	{
+		Teams.Reset();
+		return;
+	}
+
+	for (FTeamVision& Team : Teams)
+	{
+		Team.NumMembers = 0;
+		Team.MemberCells.Reset();
+	}
+
+	UNebulaReplicationGraph* NebulaGraph = CastChecked<UNebulaReplicationGraph>(GetOuter());
+	for (UNetReplicationGraphConnection* ConnManager : NebulaGraph->GetConnectionManagers())
+	{
+		UNetConnection* NetConnection = ConnManager->NetConnection;
+		const ANebulaPlayerController* PC = NetConnection ? Cast<ANebulaPlayerController>(NetConnection->PlayerController) : nullptr;
+		if (PC == nullptr || PC->GetTeamId() == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const int32 TeamId = PC->GetTeamId();
+		int32 TeamIdx = Teams.IndexOfByPredicate([TeamId](const FTeamVision& Team) { return Team.TeamId == TeamId; });
+		if (TeamIdx == INDEX_NONE)
+		{
+			TeamIdx = Teams.AddDefaulted();
+			Teams[TeamIdx].TeamId = TeamId;
+		}
+
+		FTeamVision& Team = Teams[TeamIdx];
+		if (Team.NumMembers++ == 0)
+		{
+			Team.VisibleCells.Init(false, NumCells);
+		}
+		ConnectionTeams.Add(NetConnection, TeamIdx);
+
+		// Members outside of the table add nothing, but still get the team's vision.
+		int32 ViewerCellIndex = INDEX_NONE;
+		if (PVSNode->GetViewerCellIndex(NetConnection, ViewerCellIndex) && !Team.MemberCells.Contains(ViewerCellIndex))
+		{
+			Team.MemberCells.Add(ViewerCellIndex);
+			Table.ForEachVisibleCell(ViewerCellIndex, [&Team](int32 CellIndex) { Team.VisibleCells[CellIndex] = true; });
+		}
+	}
+
+	if (!PVSNode->bUseSharedGatherLists)
+	{
+		return;
+	}
+
+	// One pass over the occupants per team. OccupiedCells was rebuilt by the PVS node's PrepareForReplication this frame.
+	for (FTeamVision& Team : Teams)
+	{
+		if (Team.NumMembers > 0)
+		{
+			PVSNode->BuildListFromCells(Team.VisibleCells, Team.ActorList, Team.FastSharedActorList);
+		}
+	}
+}
+
+void UNebulaReplicationGraphNode_PVSTeamVision::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	const int32* TeamIdx = ConnectionTeams.Find(Params.ConnectionManager.NetConnection);
+	if (TeamIdx == nullptr)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NebulaRepGraph_PVS_TeamVision);
+	CSV_SCOPED_TIMING_STAT(NebulaRepGraph, PVS_TeamVision);
+
+	const FTeamVision& Team = Teams[*TeamIdx];
+	if (PVSNode->bUseSharedGatherLists)
+	{
+		if (Team.ActorList.Num() > 0)
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(Team.ActorList);
+		}
+		if (Team.FastSharedActorList.Num() > 0)
+		{
+			Params.OutGatheredReplicationLists.AddReplicationActorList(Team.FastSharedActorList, EActorRepListTypeFlags::FastShared);
+		}
+
+	}
+
+	// Dormancy is per connection, so in shared gather list mode dormant actors still come from their GridCells.
+	PVSNode->GatherGridCells(Params, Team.VisibleCells, PVSNode->bUseSharedGatherLists);
+}
+
+bool UNebulaReplicationGraphNode_PVSTeamVision::IsCellVisibleToTeam(const UNetConnection* NetConnection, int32 CellIndex) const
+{
+	const int32* TeamIdx = ConnectionTeams.Find(NetConnection);
+	return TeamIdx && Teams[*TeamIdx].VisibleCells.IsValidIndex(CellIndex) && Teams[*TeamIdx].VisibleCells[CellIndex];
+}
+
+SIZE_T UNebulaReplicationGraphNode_PVSTeamVision::GetAllocatedSize() const
+{
+	SIZE_T Size = Teams.GetAllocatedSize() + ConnectionTeams.GetAllocatedSize();
+	for (const FTeamVision& Team : Teams)
+	{
+		Size += Team.VisibleCells.GetAllocatedSize() + Team.MemberCells.GetAllocatedSize() + (Team.ActorList.Num() + Team.FastSharedActorList.Num()) * sizeof(FActorRepListType);
+	}
+	return Size;
+}
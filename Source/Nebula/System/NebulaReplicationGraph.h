@@ -4,12 +4,28 @@
 
 #include "CoreMinimal.h"
 #include "ReplicationGraph.h"
+#include "Async/Future.h"
+#include "Components/SceneComponent.h"
 #include "NebulaReplicationGraphTypes.h"
+#include "NebulaPVSData.h"
+#include "NebulaPVSGrid.h"
 #include "NebulaReplicationGraph.generated.h"
 
 
 DECLARE_LOG_CATEGORY_EXTERN(LogNebulaRepGraph, Display, All);
 
+/** Always relevant actors of one streaming level. @see UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection */
+struct FNebulaAlwaysRelevantStreamingLevel
+{
+	FActorRepListRefView Actors;
+
+	// Actors that don't want to be dormant. Kept up to date from dormancy events, so connections know there is something to send without scanning Actors.
+	int32 NumNonDormant = 0;
+
+	// Bumped when an actor is added, wakes up or has its dormancy flushed. Connections that stopped gathering the level compare it to pick the level back up.
+	uint32 WakeSerial = 0;
+};
+
 /** Nebula Replication Graph implementation. See additional notes in NebulaReplicationGraph.cpp! */
 UCLASS(transient, config = Engine)
 class UNebulaReplicationGraph : public UReplicationGraph
@@ -20,12 +36,14 @@ class UNebulaReplicationGraph : public UReplicationGraph
 	UNebulaReplicationGraph();
 
 	virtual void ResetGameWorldState() override;
+	virtual void InitializeForWorld(UWorld* World) override;
 
 	virtual void InitGlobalActorClassSettings() override;
 	virtual void InitGlobalGraphNodes() override;
 	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
 	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
 	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool ProcessRemoteFunction(class AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, class UObject* SubObject) override;
 
 	UPROPERTY()
 	TArray<TObjectPtr<UClass>>	AlwaysRelevantClasses;
@@ -36,6 +54,9 @@ class UNebulaReplicationGraph : public UReplicationGraph
 	UPROPERTY()
 	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
 
+	UPROPERTY()
+	TObjectPtr<UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter> PlayerStateNode;
+
 	// 1) VisibilityCheck - line trace for relevancy
 
 	// 2) DynamicSpatialFrequency_VisibilityCheck - Optimized line trace for relevancy
@@ -44,11 +65,26 @@ class UNebulaReplicationGraph : public UReplicationGraph
 	UPROPERTY()
 	TObjectPtr<UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D> PVSGridNode;
 
+	// Shared vision of teammates, on top of PVSGridNode.
+	UPROPERTY()
+	TObjectPtr<UNebulaReplicationGraphNode_PVSTeamVision> PVSTeamNode;
+
+
+	TMap<FName, FNebulaAlwaysRelevantStreamingLevel> AlwaysRelevantStreamingLevelActors;
+
+	// Bumped along with the WakeSerial of any level.
+	uint32 AlwaysRelevantStreamingLevelWakeSerial = 0;
 
-	TMap<FName, FActorRepListRefView> AlwaysRelevantStreamingLevelActors;
+	// Scratch bitset of UNebulaReplicationGraphNode_DedupGatheredLists_ForConnection, keyed by object index. Connections are gathered one at a time so they share it, all bits are clear between gathers.
+	TBitArray<> GatheredActorDedupBits;
 
 	void PrintRepNodePolicies();
 
+	// Memory use and cell occupancy of every subsystem. @see Nebula.RepGraph.MemoryReport
+	void PrintMemoryReport() const;
+
+	const TArray<TObjectPtr<UNetReplicationGraphConnection>>& GetConnectionManagers() const { return Connections; }
+
 private:
 	void AddClassRepInfo(UClass* Class, EClassRepNodeMapping Mapping);
 	void RegisterClassRepNodeMapping(UClass* Class);
@@ -61,6 +97,18 @@ private:
 	EClassRepNodeMapping GetMappingPolicy(UClass* Class);
 
 	bool IsSpatialized(EClassRepNodeMapping Mapping) const { return Mapping >= EClassRepNodeMapping::Spatialize_Static; }
+	bool IsPrecomputedVisibility(EClassRepNodeMapping Mapping) const { return Mapping >= EClassRepNodeMapping::PrecomputedVisibility && Mapping <= EClassRepNodeMapping::PrecomputedVisibility_Dormancy; }
+
+	void OnStreamingLevelActorDormancyChange(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo, ENetDormancy NewValue, ENetDormancy OldValue);
+	void OnStreamingLevelActorDormancyFlush(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo);
+	void WakeStreamingLevel(FNebulaAlwaysRelevantStreamingLevel& Level);
+
+	// Sends a multicast only to the connections that can see the caller's cell, opening channels and flushing dormancy for them the way Super does.
+	// Function must be the topmost declaration. Returns false if the caller has no PVS info or can't replicate, to let the default path handle it.
+	bool ProcessMulticast_PrecomputedVisibility(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject);
+
+	// @see UNebulaReplicationGraphSettings::PVSMulticastCullingExemptFunctions
+	TSet<FName> PVSMulticastCullingExemptFunctions;
 
 	TClassMap<EClassRepNodeMapping> ClassRepNodePolicies;
 
@@ -87,12 +135,48 @@ class UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplica
 
 	void ResetGameWorldState();
 
+	// Heap memory of the per connection caches (PastRelevantActorMap, streaming level lists).
+	SIZE_T GetAllocatedSize() const;
+	int32 GetNumPastRelevantActors() const { return PastRelevantActorMap.Num(); }
+	int32 GetNumActiveStreamingLevels() const { return AlwaysRelevantStreamingLevelsNeedingReplication.Num(); }
+	int32 GetNumDormantStreamingLevels() const { return DormantStreamingLevels.Num(); }
+
 private:
+	uint32 GetOwnerPlayerStateReplicationPeriod() const;
+
+	// Client visible levels that are gathered : some actor on it is awake, or hasn't gone dormant on this connection yet.
 	TArray<FName, TInlineAllocator<64> > AlwaysRelevantStreamingLevelsNeedingReplication;
 
+	// Client visible levels with every actor dormant on this connection (or no always relevant actors), with the level's WakeSerial at that time.
+	// Only looked at when UNebulaReplicationGraph::AlwaysRelevantStreamingLevelWakeSerial changes.
+	TMap<FName, uint32> DormantStreamingLevels;
+	uint32 LastStreamingLevelWakeSerial = 0;
+
 	bool bInitializedPlayerState = false;
 };
 
+/**
+	Last connection node. Collapses every list gathered for the connection this frame into one list per list type, with each actor at most once.
+	An actor can be gathered by several nodes (e.g. the view target by AlwaysRelevant_ForConnection and again by the PVS node), and the driver
+	would otherwise prioritize and check it once per occurrence. Optional, see Nebula.RepGraph.DedupGatheredLists.
+*/
+UCLASS()
+class UNebulaReplicationGraphNode_DedupGatheredLists_ForConnection : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override {}
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override {}
+
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+	// Rebuilt every frame. Must outlive the gather since the driver reads the lists by view.
+	FActorRepListRefView DedupedLists[(int32)EActorRepListTypeFlags::Max];
+};
+
 /**
 	This is a specialized node for handling PlayerState replication in a frequency limited fashion. It tracks all player states but only returns a subset of them to the replication driver each frame.
 	This is an optimization for large player connection counts, and not a requirement.
@@ -102,11 +186,14 @@ class UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter : public UReplicat
 {
 	GENERATED_BODY()
 
+public:
 	UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter();
 
-	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override {}
-	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	// Routed from UNebulaReplicationGraph::RouteAdd/RemoveNetworkActorToNodes for every APlayerState.
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
 	virtual bool NotifyActorRenamed(const FRenamedReplicatedActorInfo& Actor, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override;
 
 	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
 
@@ -114,13 +201,33 @@ class UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter : public UReplicat
 
 	virtual void LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const override;
 
-	/** How many actors we want to return to the replication driver per frame. Will not suppress ForceNetUpdate. */
+	/** Every how many frames a connection replicates its own PlayerState (read by UNebulaReplicationGraphNode_AlwaysRelevant_ForConnection). */
+	uint32 GetOwnerPlayerStateReplicationPeriod() const { return (uint32)OwnerPlayerStateReplicationPeriod; }
+
+	/** How many actors we want to return to the replication driver per frame. Will not suppress ForceNetUpdate. Updated from the budget every frame. @see Nebula.RepGraph.PlayerState.KBytesSec */
 	int32 TargetActorsPerFrame = 2;
 
 private:
+	void UpdateBudget();
+	int32 OwnerPlayerStateReplicationPeriod = 2;
+
+	void RebuildBuckets();
+	// Appends player states added since the last prepare to the last bucket.
+	void BucketNewPlayerStates();
 
+	// Every tracked player state, with its global info cached for the ForceNetUpdate check.
+	TArray<FActorRepListType> PlayerStates;
+	TArray<FGlobalActorReplicationInfo*> PlayerStateRepInfos;
+
+	// Buckets are persistent and only touched in PrepareForReplication, since the driver reads them by view after the gather.
+	// Adds are appended to the last bucket there, removes flag them for compaction.
 	TArray<FActorRepListRefView> ReplicationActorLists;
+	int32 BucketedTargetActorsPerFrame = 0;
+	int32 NumBucketedPlayerStates = 0;
+	bool bBucketsDirty = true;
+
 	FActorRepListRefView ForceNetUpdateReplicationActorList;
+	uint32 LastPreparedFrame = 0;
 };
 
 /**
@@ -142,13 +249,18 @@ public:
 	virtual bool NotifyActorRenamed(const FRenamedReplicatedActorInfo& Actor, bool bWarnIfNotFound = true) override;
 	 // ~Pure VIrtual, but not used
 
-	//void AddActor_Static(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo) { AddActorInternal_Static(ActorInfo, ActorRepInfo, false); }
-	void AddActor_Dynamic(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo) { AddActorInternal_Dynamic(ActorInfo); }
-	//void AddActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo);
+	// The graph resets its GlobalActorReplicationInfoMap before this, so every cached actor and RepInfos pointer is dropped here.
+	virtual void NotifyResetAllNetworkActors() override;
 
-	//void RemoveActor_Static(const FNewReplicatedActorInfo& ActorInfo);
+	// Same semantics as UReplicationGraphNode_GridSpatialization2D : static actors are put in a cell once and never moved,
+	// dormancy actors are treated as static while dormant and as dynamic otherwise.
+	void AddActor_Static(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo) { AddActorInternal_Static(ActorInfo, ActorRepInfo, false); }
+	void AddActor_Dynamic(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo) { AddActorInternal_Dynamic(ActorInfo, ActorRepInfo); }
+	void AddActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo);
+
+	void RemoveActor_Static(const FNewReplicatedActorInfo& ActorInfo) { RemoveActorInternal_Static(ActorInfo); }
 	void RemoveActor_Dynamic(const FNewReplicatedActorInfo& ActorInfo) { RemoveActorInternal_Dynamic(ActorInfo); }
-	//void RemoveActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo);
+	void RemoveActor_Dormancy(const FNewReplicatedActorInfo& ActorInfo);
 
 	// trace dynmaic actors' location and cell index per frame.
 	virtual void PrepareForReplication() override;
@@ -159,41 +271,212 @@ public:
 	float		CellSize;
 	FVector2D	SpatialBias;
 	
-	void GenerateLookupTable();
+	// Loads visibility rows from baked data. Falls back to GenerateLookupTable if PVSData is null or not baked.
+	// Does nothing if PVSData is already loaded. Actors already in the node are re-bucketed if the cell layout changes.
+	void InitLookupTable(const UNebulaPVSDataAsset* PVSData);
+
+	// Placeholder table for the 7x7 test map.
+	void GenerateLookupTable(FNebulaPVSTable& OutTable) const;
+
+	// Sizes the cell storage for the current PVSTable. @see Nebula.RepGraph.PVSPreallocateGrid
+	void InitGrid();
+
+	// Copies PVSData's table and validates the copy on a worker thread, then swaps it in at the start of the first PrepareForReplication after it is ready,
+	// so a replication frame never mixes two tables. Cells and their actors are kept if the layout is unchanged, otherwise every actor is re-bucketed.
+	// Returns false if a reload is already in flight. @see Nebula.RepGraph.ReloadPVS
+	bool ReloadLookupTable(const UNebulaPVSDataAsset* PVSData);
+
+	// Resolves the PVS cell the connection views from. Returns false if it is outside of the table.
+	bool GetViewerCellIndex(const UNetConnection* NetConnection, int32& OutCellIndex) const;
+
+	// As above, but also reports viewers outside of the table as FNebulaCellId::Overflow(). False if the connection has no view target.
+	// Resolved from the connection's view point (the camera in third person), like FNetViewer::ViewLocation. Split-screen children are only handled in the gather.
+	bool GetViewerCell(const UNetConnection* NetConnection, FNebulaCellId& OutCell, FVector* OutLocation = nullptr) const;
+
+	// Within Nebula.RepGraph.PVSAudibleRange.
+	bool IsAudible(const FVector& ViewerLocation, const FVector& ActorLocation) const;
+
+	// Flat PVSTable index of the cell containing Location, INDEX_NONE if it is outside of the table.
+	int32 GetTableCellIndex(const FVector& Location) const;
+
+	const FNebulaPVSTable& GetPVSTable() const { return PVSTable; }
+	const FNebulaPVSGrid& GetPVSGrid() const { return PVSGrid; }
+
+	// Heap memory owned by the node itself (actor bookkeeping, shared lists, table, grid arrays). GridCell nodes are UObjects and not included.
+	SIZE_T GetAllocatedSize() const;
+
+	// Table, GridCells, actor arrays, per connection caches and a cell occupancy histogram. Walks every cell, debug only.
+	void PrintMemoryReport() const;
 
 protected:
 
 	//
-	void AddActorInternal_Dynamic(const FNewReplicatedActorInfo& ActorInfo);
+	void AddActorInternal_Dynamic(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo);
+	void AddActorInternal_Static(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& ActorRepInfo, bool bDormancyDriven);
 	//
 
 	//
 	void RemoveActorInternal_Dynamic(const FNewReplicatedActorInfo& ActorInfo);
+	void RemoveActorInternal_Static(const FNewReplicatedActorInfo& ActorInfo);
 	//
 
+	// Drops a removed actor from the per connection states that outlive a frame.
+	void ForgetActor(FActorRepListType Actor);
+
+	void OnNetDormancyChange(FActorRepListType Actor, FGlobalActorReplicationInfo& GlobalInfo, ENetDormancy NewValue, ENetDormancy OldValue);
+
 private:
+	// Drives PrepareForReplication and the shared gather path directly. @see Nebula.RepGraph.Benchmark
+	friend struct FNebulaReplicationGraphBenchmark;
+	// Gathers the union of a team's rows with BuildListFromCells / GatherGridCells.
+	friend class UNebulaReplicationGraphNode_PVSTeamVision;
 
 	// ----------------------
 	// |   Dynamic Actors   |
 	// ----------------------
 	struct FActorCellInfo
 	{
-		bool IsValid() const { return CellIndex.X != -1; }
-		void Reset() { CellIndex.X = -1; }
-		FIntPoint CellIndex = {-1, -1};
+		bool IsValid() const { return CellIndex.IsValid(); }
+		void Reset() { CellIndex.Reset(); }
+		FNebulaCellId CellIndex;
+	};
+
+	/**
+	* Structure of arrays, so the per-frame pass is a few linear scans instead of a hash map walk plus a GlobalRepMap lookup per actor.
+	* Removal swaps the last actor into the hole, DynamicActorIndices is the handle from actor to its current slot.
+	*/
+	struct FDynamicActorArrays
+	{
+		int32 Num() const { return Actors.Num(); }
+		int32 Add(const FNewReplicatedActorInfo& InActorInfo, FGlobalActorReplicationInfo* InRepInfo);
+		void RemoveAtSwap(int32 Index);
+		void Reset();
+
+		// Hot : touched every frame.
+		TArray<FActorRepListType> Actors;
+		TArray<FGlobalActorReplicationInfo*> RepInfos;	// Owned by GlobalActorReplicationInfoMap, stable until the actor is removed or the map is reset.
+		TArray<FVector> Locations;
+		TArray<FNebulaCellId> Cells;					// Current cells. Invalid until first bucketed.
+		TArray<FNebulaCellId> NewCells;					// Scratch for this frame's recompute.
+
+		// Cold : touched on add/remove and cell changes.
+		TArray<FNewReplicatedActorInfo> ActorInfos;
+		TArray<TWeakObjectPtr<USceneComponent>> MovementSources;	// @see Nebula.RepGraph.PVSEventDrivenUpdates
+		TBitArray<> Moved;
+	};
+
+	FDynamicActorArrays DynamicActors;
+	TMap<FActorRepListType, int32> DynamicActorIndices;
+
+	// Reads the location of one actor and moves it to its new cell if it changed.
+	void UpdateDynamicActorCell(int32 Index);
+
+	// NewCells[Index] differs from Cells[Index], but only counts once the actor is Nebula.RepGraph.PVSCellHysteresis past the boundary.
+	bool HasLeftCell(int32 Index) const;
+
+	// Moves DynamicActors[Index] from Cells[Index] to NewCells[Index].
+	void MoveDynamicActorCell(int32 Index);
+
+	// Only re-bucket dynamic actors that reported a move, instead of polling every one of them each frame.
+	bool bUseEventDrivenUpdates = false;
+	TArray<FActorRepListType> MovedDynamicActors;
+
+	void OnDynamicActorTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	// Cells the viewers of a connection can see : a single row, or the union of the rows of split-screen children and spectators in other cells.
+	struct FViewerVisibility
+	{
+		const FNebulaPVSTable* Table = nullptr;
+		int32 CellIndex = INDEX_NONE;
+		// Set when the viewers stand in more than one cell.
+		const TBitArray<>* UnionCells = nullptr;
+
+		bool IsVisible(int32 TargetCellIndex) const { return UnionCells ? (*UnionCells)[TargetCellIndex] : Table->IsVisible(CellIndex, TargetCellIndex); }
+	};
+
+	// Scratch of GatherActorListsForConnection, connections are gathered one at a time.
+	TBitArray<> ViewerUnionCells;
+
+	// Per connection lists of viewers spread over several cells. Rebuilt on each gather of that connection.
+	struct FMultiViewerList
+	{
+		FActorRepListRefView ActorList;
+		FActorRepListRefView FastSharedActorList;
+		uint32 BuiltFrame = 0;
+	};
+
+	TMap<TObjectKey<UNetConnection>, FMultiViewerList> MultiViewerLists;
+
+	// Occupants of the set cells, from the shared gather list occupancy. One pass over the occupied cells instead of one row walk per cell.
+	void BuildListFromCells(const TBitArray<>& Cells, FActorRepListRefView& OutList, FActorRepListRefView& OutFastSharedList) const;
+
+	// Gathers the GridCells of the set cells. With bDormantOnly, only cells holding dormant actors (shared gather list mode).
+	void GatherGridCells(const FConnectionGatherActorListParameters& Params, const TBitArray<>& Cells, bool bDormantOnly) const;
+
+	// -------------------------
+	// |   Audible range tier   |
+	// -------------------------
+	// Per connection list of dynamic actors in earshot but outside of the visible cells. Gathered every Nebula.RepGraph.PVSAudibleReplicationPeriod frames,
+	// which keeps their channels open for sound multicasts without widening the visibility sets.
+	struct FAudibleList
+	{
+		FActorRepListRefView ActorList;
+		uint32 BuiltFrame = 0;
+	};
+
+	TMap<TObjectKey<UNetConnection>, FAudibleList> AudibleLists;
+
+	// In earshot of any of the viewers. Only walks the cells within Nebula.RepGraph.PVSAudibleRange of them.
+	void GatherAudibleActors(const FConnectionGatherActorListParameters& Params, const FViewerVisibility& Visibility, TConstArrayView<FVector> ViewerLocations);
+
+	// Dynamic actors bucketed by table cell, built on the first audible gather of a frame : AudibleCellActors[AudibleCellStarts[C], AudibleCellStarts[C + 1]) are the indices in cell C.
+	void BuildAudibleOccupancy();
+
+	TArray<int32> AudibleCellStarts;
+	TArray<int32> AudibleCellActors;
+	uint32 AudibleOccupancyFrame = 0;
+	bool bAudibleOccupancyDirty = true;
+
+	// Scratch of GatherAudibleActors.
+	TArray<int32> AudibleScratchCells;
+
+	// Keeps channels of dynamic actors that recently left the visible cells open for Nebula.RepGraph.PVSPauseFrames, without gathering them.
+	void KeepPausedChannelsOpen(const FConnectionGatherActorListParameters& Params, const FViewerVisibility& Visibility, TConstArrayView<int32> ViewerCellIndices);
+
+	// Per connection : dynamic actors that left the visible cells and still have a channel, and the viewer cells of the last gather.
+	// Actors only leave when they change cell or the viewers do, so a gather walks those instead of every dynamic actor.
+	struct FPausedChannels
+	{
+		TArray<FActorRepListType> Actors;
+		TArray<int32, TInlineAllocator<4>> ViewerCellIndices;
+		uint32 BuiltFrame = 0;
 	};
 
-	struct FCachedDynamicActorInfo
+	TMap<TObjectKey<UNetConnection>, FPausedChannels> PausedChannels;
+
+	// Dynamic actors that changed cell during this frame's PrepareForReplication, with the cell they left.
+	TArray<TPair<FActorRepListType, FNebulaCellId>> DynamicCellChanges;
+
+	// ---------------------------------------
+	// |   Static Actors and Dormant Actors   |
+	// ---------------------------------------
+	struct FCachedStaticActorInfo
 	{
-		FCachedDynamicActorInfo(const FNewReplicatedActorInfo& InInfo) : ActorInfo(InInfo) {}
+		FCachedStaticActorInfo(const FNewReplicatedActorInfo& InInfo, bool bInDormancyDriven) : ActorInfo(InInfo), bDormancyDriven(bInDormancyDriven) {}
 		FNewReplicatedActorInfo ActorInfo;
 		FActorCellInfo CellInfo;
+		bool bDormancyDriven;	// Dormancy actor that is currently dormant. Lives in its GridCell's dormancy node.
 	};
 
+	TMap<FActorRepListType, FCachedStaticActorInfo> StaticSpatializedActors;
 
-	TMap<FActorRepListType, FCachedDynamicActorInfo> DynamicSpatializedActors;
-	// $TODO : Static Actors
-	// $TODO : Dormant Actors
+	// PVSTable with the CellSize/SpatialBias as of the last InitGrid.
+	FNebulaPVSGrid PVSGrid;
+
+	FNebulaCellId GetCellForLocation(const FVector& Location) const
+	{
+		return PVSGrid.GetCell(Location);
+	}
 
 	UReplicationGraphNode_GridCell* GetCellNode(UReplicationGraphNode_GridCell*& NodePtr)
 	{
@@ -205,8 +488,24 @@ private:
 		return NodePtr;
 	}
 
+	// Lazily grown grid, used when Nebula.RepGraph.PVSPreallocateGrid is off. Never used with two-level tables.
 	TArray<TArray<UReplicationGraphNode_GridCell*>> Grid;
 
+	// Preallocated grid indexed like PVSTable.
+	TArray<UReplicationGraphNode_GridCell*> FlatGrid;
+	bool bUseFlatGrid = false;
+
+	// Everything outside of the PVS table bounds. There is no visibility info out there, so it is only gathered by viewers also out of bounds.
+	// Always a real GridCell, even with shared gather lists, since shared lists are built from table rows.
+	UReplicationGraphNode_GridCell* OverflowCell = nullptr;
+
+	bool LivesInGridCell(FNebulaCellId Cell) const { return !bUseSharedGatherLists || Cell.IsOverflow(); }
+
+	int32 GetFlatCellIndex(int32 X, int32 Y) const
+	{
+		return PVSTable.GetCellIndex(X, Y);
+	}
+
 	TArray<UReplicationGraphNode_GridCell*>& GetGridX(int32 X)
 	{
 		if (Grid.Num() <= X)
@@ -225,12 +524,197 @@ private:
 		return GridX[Y];
 	}
 
-	UReplicationGraphNode_GridCell*& GetCell(int32 X, int32 Y)
+	// Cell must come from GetCellForLocation, so it is either inside the table bounds or the overflow cell.
+	UReplicationGraphNode_GridCell*& GetCell(FNebulaCellId Cell)
+	{
+		if (Cell.IsOverflow())
+		{
+			return OverflowCell;
+		}
+
+		if (bUseFlatGrid)
+		{
+			return FlatGrid[GetFlatCellIndex(Cell.GetX(), Cell.GetY())];
+		}
+
+		TArray<UReplicationGraphNode_GridCell*>& GridX = GetGridX(Cell.GetX());
+		return GetCell(GridX, Cell.GetY());
+	}
+
+	// Returns the cell if it already exists. Never allocates.
+	UReplicationGraphNode_GridCell* FindCell(FNebulaCellId Cell) const
+	{
+		if (Cell.IsOverflow())
+		{
+			return OverflowCell;
+		}
+
+		const int32 X = Cell.GetX();
+		const int32 Y = Cell.GetY();
+		if (bUseFlatGrid)
+		{
+			return PVSTable.IsValidCell(X, Y) ? FlatGrid[GetFlatCellIndex(X, Y)] : nullptr;
+		}
+
+		return (Grid.IsValidIndex(X) && Grid[X].IsValidIndex(Y)) ? Grid[X][Y] : nullptr;
+	}
+
+	// As above, from a PVSTable cell index.
+	UReplicationGraphNode_GridCell* FindCell(int32 CellIndex) const
 	{
-		TArray<UReplicationGraphNode_GridCell*>& GridX = GetGridX(X);
-		return GetCell(GridX, Y);
+		if (bUseFlatGrid)
+		{
+			return FlatGrid[CellIndex];
+		}
+
+		const FIntPoint Cell = PVSTable.GetCell(CellIndex);
+		return FindCell(FNebulaCellId(Cell.X, Cell.Y));
 	}
 
-	// $TODO : compress each coordinates, for memory footprint - FIntPoint is 4bytes
-	TMap<FIntPoint, TArray<FIntPoint>> PVSLookupTable;
-};
\ No newline at end of file
+	// ------------------------------
+	// |   Shared gather lists      |
+	// ------------------------------
+	// @see Nebula.RepGraph.PVSSharedGatherLists
+	// In this mode dynamic and static actors are not put in GridCells at all, only dormant actors are (for per-connection dormancy).
+	bool bUseSharedGatherLists = false;
+
+	struct FOccupiedCellActor
+	{
+		int32 CellIndex;
+		FActorRepListType Actor;
+		// Not in this frame's frequency bucket : only gets a FastShared update. @see Nebula.RepGraph.EnableFastSharedPath
+		bool bFastShared = false;
+	};
+
+	struct FSharedViewerCellList
+	{
+		// Split by distance tier. @see Nebula.RepGraph.PVSTierMidDistance
+		FActorRepListRefView ActorList;
+		FActorRepListRefView MidActorList;
+		FActorRepListRefView FarActorList;
+		FActorRepListRefView FastSharedActorList;
+		uint32 BuiltFrame = 0;
+	};
+
+	void BuildSharedGatherLists();
+	void RebuildStaticOccupancy();
+	const FSharedViewerCellList& GetOrBuildSharedList(int32 ViewerCellIndex);
+
+	// Merge-joins the viewer cell's row against the occupied cells. Only reads node state, so lists of different cells can be built concurrently.
+	void BuildSharedList(int32 ViewerCellIndex, FSharedViewerCellList& SharedList) const;
+
+	// Center of a cell in grid coordinates.
+	FVector2D GetCellCenter(int32 CellIndex) const;
+
+	// ---------------------------
+	// |   Distance tiers         |
+	// ---------------------------
+	// Per connection : actors whose ReplicationPeriodFrame the last gather raised, with the period they had before.
+	struct FDistanceTierState
+	{
+		TArray<TPair<FActorRepListType, uint32>> ReducedActors;
+		uint32 BuiltFrame = 0;
+	};
+
+	TMap<TObjectKey<UNetConnection>, FDistanceTierState> DistanceTierStates;
+
+	// Raises the period of the mid/far tier actors of SharedList on this connection, and restores the ones that are no longer in those tiers.
+	// Pass null for connections not gathering a tiered list this frame.
+	void UpdateDistanceTierPeriods(const FConnectionGatherActorListParameters& Params, const FSharedViewerCellList* SharedList);
+
+	// Lists to build this frame, with their viewer cell. Scratch of BuildSharedGatherLists.
+	TArray<TPair<int32, FSharedViewerCellList*>> PendingSharedLists;
+
+	// Viewer cells without a connection, queued along with the connections' ones. @see Nebula.RepGraph.Benchmark
+	TArray<int32> SyntheticViewerCells;
+
+	// Sorted by cell index. Dynamic ones are rebuilt each frame, static ones only when static actors change.
+	TArray<FOccupiedCellActor> OccupiedCells;
+	TArray<FOccupiedCellActor> StaticOccupiedCells;
+	// Sorted unique cells holding at least one dormant actor.
+	TArray<int32> DormantCells;
+	bool bStaticOccupancyDirty = false;
+
+	// Heap allocated so lists already handed out to a connection stay valid when another one is added mid-gather.
+	TMap<int32, TUniquePtr<FSharedViewerCellList>> SharedViewerCellLists;
+	uint32 SharedListsFrame = 0;
+
+	FNebulaPVSTable PVSTable;
+
+	// ------------------------------
+	// |   Table hot-reload         |
+	// ------------------------------
+	// Swaps in the table built by ReloadLookupTable. Null if it failed validation.
+	void ApplyPendingLookupTable();
+
+	// Swaps in NewTable. Cells and their actors are kept if the layout is unchanged, otherwise actors are re-bucketed.
+	// Returns true if the layout was unchanged.
+	bool SetLookupTable(FNebulaPVSTable&& NewTable, float NewCellSize, const FVector2D& NewSpatialBias);
+
+	// Removes every actor with the current layout, rebuilds the grid for NewTable/NewCellSize/NewSpatialBias and adds them back.
+	void RebucketAllActors(FNebulaPVSTable&& NewTable, float NewCellSize, const FVector2D& NewSpatialBias);
+
+	// Asset the current table was loaded from. Null for the placeholder table.
+	TWeakObjectPtr<const UNebulaPVSDataAsset> LoadedPVSData;
+	bool bLookupTableLoaded = false;
+
+	// Kept alive until the table checked by the worker is applied, it provides the cell layout.
+	UPROPERTY()
+	TObjectPtr<const UNebulaPVSDataAsset> PendingPVSData;
+
+	TFuture<TSharedPtr<FNebulaPVSTable>> PendingLookupTable;
+};
+
+/**
+* Shared vision for teams. Once per frame, ORs the PVS rows of every team member's viewer cell into one cell bitset per team,
+* and in shared gather list mode also builds one gather list per team from it. Every connection on the team gathers that instead of its own row,
+* so the cost is per team rather than per pair of teammates. Must be added after the PVS node, it reads the occupancy that node builds.
+* @see Nebula.RepGraph.PVSTeamVision, ANebulaPlayerController::SetTeamId
+*/
+UCLASS()
+class UNebulaReplicationGraphNode_PVSTeamVision : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UNebulaReplicationGraphNode_PVSTeamVision();
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& Actor) override {}
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override {}
+
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	// True if the connection was on a team at PrepareForReplication. Its visible actors then come from this node, not from the PVS node.
+	bool IsTeamConnection(const UNetConnection* NetConnection) const { return ConnectionTeams.Contains(NetConnection); }
+
+	// Whether any teammate of the connection can see the cell. False if the connection isn't on a team.
+	bool IsCellVisibleToTeam(const UNetConnection* NetConnection, int32 CellIndex) const;
+
+	int32 GetNumTeams() const { return Teams.Num(); }
+	SIZE_T GetAllocatedSize() const;
+
+	UPROPERTY()
+	TObjectPtr<UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D> PVSNode;
+
+private:
+	struct FTeamVision
+	{
+		int32 TeamId = INDEX_NONE;
+		int32 NumMembers = 0;
+
+		// Union of the members' rows, one bit per PVSTable cell.
+		TBitArray<> VisibleCells;
+		// Viewer cells already ORed in this frame, teammates often stand in the same cell.
+		TArray<int32, TInlineAllocator<8>> MemberCells;
+
+		// Occupants of VisibleCells. Shared gather list mode only.
+		FActorRepListRefView ActorList;
+		FActorRepListRefView FastSharedActorList;
+	};
+
+	// Teams are few, a linear search beats hashing. Teams left without members are dropped on the next frame, so indices stay valid for the whole frame.
+	TArray<FTeamVision> Teams;
+	TMap<TObjectKey<UNetConnection>, int32> ConnectionTeams;
+};
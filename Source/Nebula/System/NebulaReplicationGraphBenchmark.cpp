@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+/**
+*	Nebula.RepGraph.Benchmark [NumActors] [NumViewers] [NumFrames]
+*
+*	Spawns NumActors ANebulaCharacter in the current server world, moves them on a fixed pattern for NumFrames frames and drives the
+*	PrecomputedVisibilityGrid2D node directly. Viewers stand where the first NumViewers actors stand, like players would.
+*	Runs synchronously, so it works on a headless dedicated server or -nullrhi build agent.
+*
+*	What is measured : PrepareForReplication (re-bucketing, occupancy, and in shared gather list mode the build of one list per viewer cell,
+*	queued with the connections' cells so Nebula.RepGraph.PVSParallelGather applies), then handing each viewer its cell's list.
+*	What isn't : the rest of GatherActorListsForConnection (GridCell mode, multi-viewer unions, audible, pause, distance tiers, overflow),
+*	which needs a UNetReplicationGraphConnection with a live UNetConnection. Memory is the node's own GetAllocatedSize, not every allocation made.
+*	Compare modes by re-running with the Nebula.RepGraph.PVS* switches.
+*/
+
+#include "NebulaReplicationGraph.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Nebula/NebulaCharacter.h"
+
+struct FNebulaReplicationGraphBenchmark
+{
+	struct FTiming
+	{
+		double Total = 0.0;
+		double Max = 0.0;
+
+		void Add(double Seconds)
+		{
+			Total += Seconds;
+			Max = FMath::Max(Max, Seconds);
+		}
+	};
+
+	static void Run(UWorld* World, int32 NumActors, int32 NumViewers, int32 NumFrames)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		UNebulaReplicationGraph* Graph = NetDriver ? Cast<UNebulaReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+		UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D* Node = Graph ? Graph->PVSGridNode.Get() : nullptr;
+		if (Node == nullptr)
+		{
+			UE_LOG(LogNebulaRepGraph, Error, TEXT("Nebula.RepGraph.Benchmark - needs a server world running UNebulaReplicationGraph."));
+			return;
+		}
+
+		const FNebulaPVSTable& Table = Node->GetPVSTable();
+		const FVector2D GridMin = Node->SpatialBias;
+		const FVector2D GridExtent = FVector2D(Table.GetNumX(), Table.GetNumY()) * Node->CellSize;
+
+		// Fixed seed : runs compare against each other.
+		FRandomStream Random(0x4E42);
+
+		TArray<ANebulaCharacter*> Actors;
+		TArray<FVector> Origins;
+		Actors.Reserve(NumActors);
+		Origins.Reserve(NumActors);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		for (int32 i = 0; i < NumActors; ++i)
+		{
+			const FVector Origin(GridMin.X + Random.FRand() * GridExtent.X, GridMin.Y + Random.FRand() * GridExtent.Y, 100.f);
+			if (ANebulaCharacter* Actor = World->SpawnActor<ANebulaCharacter>(ANebulaCharacter::StaticClass(), Origin, FRotator::ZeroRotator, SpawnParams))
+			{
+				Actors.Add(Actor);
+				Origins.Add(Origin);
+			}
+		}
+
+		NumViewers = FMath::Min(NumViewers, Actors.Num());
+		const SIZE_T StartSize = Node->GetAllocatedSize();
+		const bool bSharedLists = Node->bUseSharedGatherLists;
+
+		FTiming PrepareTiming;
+		FTiming GatherTiming;
+		int64 TotalGatheredActors = 0;
+		int32 MaxGatheredActors = 0;
+		int64 TotalSharedListsBuilt = 0;
+
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			// Circles of one to two cells, with a phase per actor, so a steady share of actors crosses cell boundaries every frame.
+			for (int32 i = 0; i < Actors.Num(); ++i)
+			{
+				const float Radius = Node->CellSize * (1.f + (i % 2));
+				const float Angle = (Frame + i * 7) * 0.05f;
+				Actors[i]->SetActorLocation(Origins[i] + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius, false, nullptr, ETeleportType::TeleportPhysics);
+			}
+
+			// Built by PrepareForReplication, like the cells of real connections.
+			TArray<int32>& ViewerCells = Node->SyntheticViewerCells;
+			ViewerCells.Reset();
+			for (int32 i = 0; i < NumViewers; ++i)
+			{
+				ViewerCells.Add(Node->GetTableCellIndex(Actors[i]->GetActorLocation()));
+			}
+			ViewerCells.Remove(INDEX_NONE);
+
+			double StartTime = FPlatformTime::Seconds();
+			Node->PrepareForReplication();
+			PrepareTiming.Add(FPlatformTime::Seconds() - StartTime);
+
+			if (!bSharedLists)
+			{
+				continue;
+			}
+
+			TotalSharedListsBuilt += Node->PendingSharedLists.Num();
+
+			StartTime = FPlatformTime::Seconds();
+			for (const int32 ViewerCellIndex : ViewerCells)
+			{
+				const UNebularReplicationGraphNode_PrecomputedVisibilityGrid2D::FSharedViewerCellList& SharedList = Node->GetOrBuildSharedList(ViewerCellIndex);
+				const int32 NumGathered = SharedList.ActorList.Num() + SharedList.MidActorList.Num() + SharedList.FarActorList.Num();
+				TotalGatheredActors += NumGathered;
+				MaxGatheredActors = FMath::Max(MaxGatheredActors, NumGathered);
+			}
+			GatherTiming.Add(FPlatformTime::Seconds() - StartTime);
+		}
+
+		const SIZE_T EndSize = Node->GetAllocatedSize();
+		Node->SyntheticViewerCells.Reset();
+
+		for (ANebulaCharacter* Actor : Actors)
+		{
+			Actor->Destroy();
+		}
+
+		const double ToMs = 1000.0 / FMath::Max(NumFrames, 1);
+		UE_LOG(LogNebulaRepGraph, Display, TEXT("Nebula.RepGraph.Benchmark - %d actors, %d viewers, %d frames, %dx%d cells"), Actors.Num(), NumViewers, NumFrames, Table.GetNumX(), Table.GetNumY());
+		UE_LOG(LogNebulaRepGraph, Display, TEXT("  PrepareForReplication : avg %.3f ms, max %.3f ms"), PrepareTiming.Total * ToMs, PrepareTiming.Max * 1000.0);
+		if (bSharedLists)
+		{
+			const IConsoleVariable* ParallelGatherCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Nebula.RepGraph.PVSParallelGather"));
+			UE_LOG(LogNebulaRepGraph, Display, TEXT("  Shared lists built in PrepareForReplication : avg %.1f per frame (%s)"), (double)TotalSharedListsBuilt / NumFrames,
+				ParallelGatherCVar && ParallelGatherCVar->GetInt() > 0 ? TEXT("parallel above PVSParallelGatherMinCells") : TEXT("serial"));
+			UE_LOG(LogNebulaRepGraph, Display, TEXT("  List hand-out (all viewers) : avg %.3f ms, max %.3f ms"), GatherTiming.Total * ToMs, GatherTiming.Max * 1000.0);
+			UE_LOG(LogNebulaRepGraph, Display, TEXT("  Gathered actors per viewer : avg %.1f, max %d"), (double)TotalGatheredActors / FMath::Max(NumFrames * NumViewers, 1), MaxGatheredActors);
+		}
+		else
+		{
+			UE_LOG(LogNebulaRepGraph, Display, TEXT("  Gather not measured : GridCell mode gathers need a live connection, only PrepareForReplication is timed."));
+		}
+		UE_LOG(LogNebulaRepGraph, Display, TEXT("  Node heap (GetAllocatedSize) : %llu -> %llu bytes"), (uint64)StartSize, (uint64)EndSize);
+	}
+};
+
+FAutoConsoleCommandWithWorldAndArgs NebulaRepGraphBenchmarkCmd(TEXT("Nebula.RepGraph.Benchmark"), TEXT("Benchmarks the PVS node's PrepareForReplication and shared gather list build with synthetic actors and viewers. Per connection gather work isn't measured. Usage: Nebula.RepGraph.Benchmark [NumActors=200] [NumViewers=100] [NumFrames=300]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			const int32 NumActors = Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 200;
+			const int32 NumViewers = Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 100;
+			const int32 NumFrames = Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : 300;
+			FNebulaReplicationGraphBenchmark::Run(World, FMath::Max(NumActors, 1), FMath::Max(NumViewers, 0), FMath::Max(NumFrames, 1));
+		}));
+
+#endif
@@ -7,7 +7,7 @@
 #include "NebulaReplicationGraphTypes.h"
 #include "NebulaReplicationGraphSettings.generated.h"
 
-#define bUseFastPath 0
+class UNebulaPVSDataAsset;
 
 /**
  * Default settings for the Nebula replication graph
@@ -28,17 +28,18 @@ public:
 	UPROPERTY(config, EditAnywhere, Category = ReplicationGraph, meta = (MetaClass = "/Script/Nebula.NebulaReplicationGraph"))
 	FSoftClassPath DefaultReplicationGraphClass;
 
-#if bUseFastPath // TODO : FastShared Settings
-//	UPROPERTY(EditAnywhere, Category = FastSharedPath, meta = (ConsoleVariable = "Nebula.RepGraph.EnableFastSharedPath"))
+	// Send character movement between full updates through one shared bunch per character per frame. @see ANebulaCharacter::UpdateSharedReplication
+	UPROPERTY(EditAnywhere, Category = FastSharedPath, meta = (ConsoleVariable = "Nebula.RepGraph.EnableFastSharedPath"))
 	bool bEnableFastSharedPath = true;
 
 	// How much bandwidth to use for FastShared movement updates. This is counted independently of the NetDriver's target bandwidth.
-//	UPROPERTY(EditAnywhere, Category = FastSharedPath, meta = (ForceUnits = Kilobytes, ConsoleVariable = "Nebula.RepGraph.TargetKBytesSecFastSharedPath"))
+	UPROPERTY(EditAnywhere, Category = FastSharedPath, meta = (ForceUnits = Kilobytes, ConsoleVariable = "Nebula.RepGraph.TargetKBytesSecFastSharedPath"))
 	int32 TargetKBytesSecFastSharedPath = 10;
 
-//	UPROPERTY(EditAnywhere, Category = FastSharedPath, meta = (ConsoleVariable = "Nebula.RepGraph.FastSharedPathCullDistPct"))
+	// FastShared updates are only sent to connections within this fraction of the actor's cull distance.
+	UPROPERTY(EditAnywhere, Category = FastSharedPath, meta = (ConsoleVariable = "Nebula.RepGraph.FastSharedPathCullDistPct"))
 	float FastSharedPathCullDistPct = 0.80f;
-#endif
+
 	UPROPERTY(EditAnywhere, Category = DestructionInfo, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.DestructInfo.MaxDist"))
 	float DestructionInfoMaxDist = 30000.f;
 
@@ -46,17 +47,96 @@ public:
 	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.PVSCellSize"))
 	float PVSSCellSize = 200.0f;
 
-	// Essentially "Min X" for "PrecomputedVisibilityGrid2D Node". This is just an initial value. The system will reset itself if actors appears outside of this.
+	// Essentially "Min X" for "PrecomputedVisibilityGrid2D Node". Overridden by the baked PVS data. Actors outside of the table bounds share one overflow cell, the grid is never rebuilt.
 	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.PVSSpatialBiasX"))
 	float PVSSpatialBiasX = -600.f;
 
-	// Essentially "Min Y" for"PrecomputedVisibilityGrid2D Node". This is just an initial value. The system will reset itself if actors appears outside of this.
+	// Essentially "Min Y" for"PrecomputedVisibilityGrid2D Node". Overridden by the baked PVS data. Actors outside of the table bounds share one overflow cell, the grid is never rebuilt.
 	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.PVSSpatialBiasY"))
 	float PVSSpatialBiasY = -600.f;
 
+	// Use one flat cell array sized from the PVS table bounds, so per-frame paths never grow the grid.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSPreallocateGrid"))
+	bool bPVSPreallocateGrid = true;
+
+	// Build one merged gather list per occupied viewer cell in PrepareForReplication and share it across all connections standing in that cell.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSSharedGatherLists"))
+	bool bPVSSharedGatherLists = true;
+
+	// Build the shared gather lists of all occupied viewer cells across worker threads. Connections then only pick up their cell's list in the serial gather.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSParallelGather"))
+	bool bPVSParallelGather = true;
+
+	// Players on the same team (ANebulaPlayerController::SetTeamId) see everything any teammate's viewer cell can see.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSTeamVision"))
+	bool bPVSTeamVision = true;
+
+	// Only re-bucket PVS dynamic actors whose root component reported a move, instead of polling all of them every frame. Good for large idle crowds.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSEventDrivenUpdates"))
+	bool bPVSEventDrivenUpdates = false;
+
+	// Only send multicast RPCs of PVS routed actors to connections whose viewer cell can see the caller's cell. The owning connection always receives them.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSMulticastCulling"))
+	bool bPVSMulticastCulling = true;
+
+	// Multicast functions that bypass PVS culling (e.g. match-wide announcements, audio that must be heard through walls).
+	UPROPERTY(config, EditAnywhere, Category = SpatialGrid)
+	TArray<FName> PVSMulticastCullingExemptFunctions;
+
+	// Dynamic actors within this 2D distance but outside of the viewer's visible cells are still gathered at a lower rate, so they can be heard. 0 disables the audible tier.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.PVSAudibleRange"))
+	float PVSAudibleRange = 3000.f;
+
+	// Audible-only actors are gathered once every this many replication frames. Keep it well below the channel close timeout.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSAudibleReplicationPeriod"))
+	int32 PVSAudibleReplicationPeriod = 4;
+
+	// Visible actors in cells at least this far from the viewer's cell are replicated at a lower rate. 0 replicates everything visible at the full rate.
+	// Only applies to connections whose viewers share one cell, with Nebula.RepGraph.PVSSharedGatherLists on :
+	// GridCell mode, team and multi-viewer connections are never tiered.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.PVSTierMidDistance"))
+	float PVSTierMidDistance = 6000.f;
+
+	// Visible actors in cells at least this far from the viewer's cell use the far tier period. 0 disables the far tier. Shared gather list mode only, see PVSTierMidDistance.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.PVSTierFarDistance"))
+	float PVSTierFarDistance = 12000.f;
+
+	// Mid tier actors replicate at most once every this many replication frames to a connection. Shared gather list mode only, see PVSTierMidDistance.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSTierMidReplicationPeriod"))
+	int32 PVSTierMidReplicationPeriod = 2;
+
+	// Far tier actors replicate at most once every this many replication frames to a connection. Shared gather list mode only, see PVSTierMidDistance.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSTierFarReplicationPeriod"))
+	int32 PVSTierFarReplicationPeriod = 4;
+
+	// Frames an actor channel is kept open, but not replicated, after a dynamic actor leaves the viewer's visible cells. Avoids re-sending the initial bunch
+	// of actors flickering at cell boundaries. 0 closes channels as soon as the engine times them out.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.PVSPauseFrames"))
+	int32 PVSPauseFrames = 60;
+
+	// Dynamic actors only move to another cell once they are this far past the boundary of their current one, so actors walking along an edge don't thrash both cells.
+	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ForceUnits = cm, ConsoleVariable = "Nebula.RepGraph.PVSCellHysteresis"))
+	float PVSCellHysteresis = 50.f;
+
+	// Baked PVS table per map, loaded by the server in UNebulaReplicationGraph::InitGlobalGraphNodes. Maps without an entry fall back to the placeholder test table.
+	UPROPERTY(config, EditAnywhere, Category = SpatialGrid)
+	TMap<TSoftObjectPtr<UWorld>, TSoftObjectPtr<UNebulaPVSDataAsset>> PVSDataPerMap;
+
 	UPROPERTY(EditAnywhere, Category = SpatialGrid, meta = (ConsoleVariable = "Nebula.RepGraph.DisableSpatialRebuilds"))
 	bool bDisableSpatialRebuilds = true;
 
+	// Per connection bandwidth PlayerState updates (the rolling subset plus the owner's own PlayerState) may use.
+	UPROPERTY(EditAnywhere, Category = PlayerState, meta = (ForceUnits = Kilobytes, ConsoleVariable = "Nebula.RepGraph.PlayerState.KBytesSec"))
+	float PlayerStateKBytesSec = 8.f;
+
+	// Average size of one PlayerState update, used to turn the budget into actors per frame.
+	UPROPERTY(EditAnywhere, Category = PlayerState, meta = (ForceUnits = Bytes, ConsoleVariable = "Nebula.RepGraph.PlayerState.EstimatedBytes"))
+	int32 PlayerStateEstimatedBytes = 64;
+
+	// Time we'd like a full pass over every PlayerState to take. Only reached while it fits the budget, beyond that passes get longer with the player count.
+	UPROPERTY(EditAnywhere, Category = PlayerState, meta = (ForceUnits = s, ConsoleVariable = "Nebula.RepGraph.PlayerState.FullCycleSeconds"))
+	float PlayerStateFullCycleSeconds = 0.5f;
+
 	// How many buckets to spread dynamic, spatialized actors across.
 	// High number = more buckets = smaller effective replication frequency.
 	// This happens before individual actors do their own NetUpdateFrequency check.
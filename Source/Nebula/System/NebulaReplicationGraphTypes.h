@@ -11,7 +11,9 @@ enum class EClassRepNodeMapping : uint32
 {
 	NotRouted,						// Doesn't map to any node. Used for special case actors that handled by special case nodes (UNebulaReplicationGraphNode_PlayerStateFrequencyLimiter)
 	RelevantAllConnections,			// Routes to an AlwaysRelevantNode or AlwaysRelevantStreamingLevelNode node
-	PrecomputedVisibility,
+	PrecomputedVisibility,			// Routes to PVSGridNode: these actors move frequently and are re-bucketed once per frame.
+	PrecomputedVisibility_Static,	// Routes to PVSGridNode: these actors don't move and don't need to be updated every frame.
+	PrecomputedVisibility_Dormancy,	// Routes to PVSGridNode: While dormant we treat as static. When flushed/not dormant dynamic.
 
 	// ONLY SPATIALIZED Enums below here! See UNebulaReplicationGraph::IsSpatialized
 